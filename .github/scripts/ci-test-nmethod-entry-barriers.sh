@@ -0,0 +1,42 @@
+set -xe
+
+. $(dirname "$0")/common.sh
+
+unset JAVA_TOOL_OPTIONS
+
+cd $OPENJDK_PATH
+
+# Arm the nmethods whose oops moved, and patch them on their next entry.
+
+# --- SemiSpace ---
+export MMTK_PLAN=SemiSpace
+
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
+
+# --- Immix ---
+export MMTK_PLAN=Immix
+
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
+
+# --- GenImmix ---
+export MMTK_PLAN=GenImmix
+
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
+
+# --- GenCopy ---
+export MMTK_PLAN=GenCopy
+
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
+
+# Nursery GCs with partial stack scanning patch all the moved nmethods in the pause
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap "-XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true openjdk_partial_stack_scanning=true" -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap "-XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true openjdk_partial_stack_scanning=true" -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap "-XX:ThirdPartyHeapOptions=openjdk_nmethod_entry_barriers=true openjdk_partial_stack_scanning=true" -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
@@ -0,0 +1,31 @@
+set -xe
+
+. $(dirname "$0")/common.sh
+
+unset JAVA_TOOL_OPTIONS
+cd $OPENJDK_PATH
+
+# Skip the stack frames that have not run since the last GC in nursery GCs.
+# Only the generational plans do nursery GCs.
+
+# --- GenCopy ---
+export MMTK_PLAN=GenCopy
+
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar pmd
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar hsqldb
+# Deoptimization rewrites the frames of compiled methods
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -XX:+UnlockDiagnosticVMOptions -XX:+DeoptimizeALot -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+
+# --- GenImmix ---
+export MMTK_PLAN=GenImmix
+
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar antlr
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar luindex
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar pmd
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar hsqldb
+# Deoptimization rewrites the frames of compiled methods
+build/linux-x86_64-normal-server-$DEBUG_LEVEL/jdk/bin/java -XX:+UseThirdPartyHeap -XX:ThirdPartyHeapOptions=openjdk_partial_stack_scanning=true -server -XX:MetaspaceSize=100M -XX:+UnlockDiagnosticVMOptions -XX:+DeoptimizeALot -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar fop
@@ -13,3 +13,7 @@ cd $cur
 ./ci-test-global-alloc-bit.sh
 cd $cur
 ./ci-test-malloc-mark-sweep.sh
+cd $cur
+./ci-test-partial-stack-scanning.sh
+cd $cur
+./ci-test-nmethod-entry-barriers.sh
@@ -2,10 +2,12 @@ use super::UPCALLS;
 use crate::OpenJDK;
 use crate::SINGLETON;
 use mmtk::util::opaque_pointer::*;
+use mmtk::util::Address;
 use mmtk::vm::ActivePlan;
 use mmtk::Mutator;
 use mmtk::Plan;
-use std::sync::Mutex;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::RwLock;
 
 pub struct VMActivePlan {}
 
@@ -26,28 +28,76 @@ impl ActivePlan<OpenJDK> for VMActivePlan {
     }
 
     fn reset_mutator_iterator() {
-        unsafe {
-            ((*UPCALLS).reset_mutator_iterator)();
-        }
+        // The snapshot holds raw pointers to the mutators, which may dangle once the threads are
+        // resumed and can exit. So the mutators are only enumerated while they are stopped.
+        assert!(
+            SNAPSHOT_IS_CURRENT.load(Ordering::Relaxed),
+            "mutators can only be enumerated while they are stopped"
+        );
+        MUTATOR_ITERATOR_CURSOR.store(0, Ordering::Relaxed);
     }
 
     fn get_next_mutator() -> Option<&'static mut Mutator<OpenJDK>> {
-        let _guard = MUTATOR_ITERATOR_LOCK.lock().unwrap();
-        unsafe {
-            let m = ((*UPCALLS).get_next_mutator)();
-            if m.is_null() {
-                None
-            } else {
-                Some(&mut *m)
-            }
-        }
+        let index = MUTATOR_ITERATOR_CURSOR.fetch_add(1, Ordering::Relaxed);
+        MUTATORS_SNAPSHOT
+            .read()
+            .unwrap()
+            .get(index)
+            .map(|m| unsafe { &mut *m.to_mut_ptr::<Mutator<OpenJDK>>() })
     }
 
     fn number_of_mutators() -> usize {
-        unsafe { ((*UPCALLS).number_of_mutators)() }
+        if SNAPSHOT_IS_CURRENT.load(Ordering::Relaxed) {
+            MUTATORS_SNAPSHOT.read().unwrap().len()
+        } else {
+            unsafe { ((*UPCALLS).number_of_mutators)() }
+        }
     }
 }
 
 lazy_static! {
-    pub static ref MUTATOR_ITERATOR_LOCK: Mutex<()> = Mutex::new(());
+    /// The mutators of all Java threads, taken in one upcall when the mutators are stopped.
+    /// GC workers read it concurrently, each claiming mutators through `MUTATOR_ITERATOR_CURSOR`.
+    static ref MUTATORS_SNAPSHOT: RwLock<Vec<Address>> = RwLock::new(vec![]);
+}
+
+/// The index in `MUTATORS_SNAPSHOT` of the next mutator returned by `get_next_mutator`.
+static MUTATOR_ITERATOR_CURSOR: AtomicUsize = AtomicUsize::new(0);
+
+/// Whether `MUTATORS_SNAPSHOT` was taken while the mutators are stopped, and is still accurate.
+static SNAPSHOT_IS_CURRENT: AtomicBool = AtomicBool::new(false);
+
+/// Take the snapshot used by all the enumerations of mutators until they are resumed.
+pub(crate) fn on_mutators_stopped() {
+    take_mutators_snapshot();
+    SNAPSHOT_IS_CURRENT.store(true, Ordering::Relaxed);
+}
+
+pub(crate) fn on_mutators_resumed() {
+    SNAPSHOT_IS_CURRENT.store(false, Ordering::Relaxed);
+}
+
+/// Take a new snapshot of the mutators, and restart the iteration over them.
+fn take_mutators_snapshot() {
+    let mut snapshot = MUTATORS_SNAPSHOT.write().unwrap();
+    snapshot.clear();
+    loop {
+        let capacity = snapshot.capacity();
+        let length = unsafe { ((*UPCALLS).get_mutators)(snapshot.as_mut_ptr(), capacity) };
+        if length <= capacity {
+            unsafe { snapshot.set_len(length) };
+            break;
+        }
+        // More threads than the last snapshot. Retry with room for all of them.
+        snapshot.reserve(length);
+    }
+    MUTATOR_ITERATOR_CURSOR.store(0, Ordering::Relaxed);
+}
+
+/// Call `f` with each mutator of the snapshot taken when the mutators were stopped.
+pub(crate) fn for_each_mutator(mut f: impl FnMut(&'static mut Mutator<OpenJDK>)) {
+    debug_assert!(SNAPSHOT_IS_CURRENT.load(Ordering::Relaxed));
+    for m in MUTATORS_SNAPSHOT.read().unwrap().iter() {
+        f(unsafe { &mut *m.to_mut_ptr::<Mutator<OpenJDK>>() });
+    }
 }
@@ -18,7 +18,7 @@ use mmtk::MutatorContext;
 use once_cell::sync;
 use std::cell::RefCell;
 use std::ffi::{CStr, CString};
-use std::sync::atomic::Ordering;
+use std::sync::atomic::{AtomicBool, AtomicU8, AtomicUsize, Ordering};
 
 // Supported barriers:
 static NO_BARRIER: sync::Lazy<CString> = sync::Lazy::new(|| CString::new("NoBarrier").unwrap());
@@ -45,7 +45,8 @@ pub extern "C" fn mmtk_active_barrier() -> *const c_char {
 /// Caller needs to make sure the ptr is a valid vector pointer.
 #[no_mangle]
 pub unsafe extern "C" fn release_buffer(ptr: *mut Address, length: usize, capacity: usize) {
-    let _vec = Vec::<Address>::from_raw_parts(ptr, length, capacity);
+    let vec = Vec::<Address>::from_raw_parts(ptr, length, capacity);
+    crate::edge_buffers::release_buffer(vec);
 }
 
 #[no_mangle]
@@ -214,6 +215,18 @@ pub extern "C" fn is_in_mmtk_spaces(object: ObjectReference) -> bool {
     memory_manager::is_in_mmtk_spaces(object)
 }
 
+/// Whether `object` survived the current GC. Only valid after the transitive closure.
+#[no_mangle]
+pub extern "C" fn mmtk_is_live(object: ObjectReference) -> bool {
+    object.is_live()
+}
+
+/// The new location of `object` if the current GC moved it, or `object` itself.
+#[no_mangle]
+pub extern "C" fn mmtk_get_forwarded_object(object: ObjectReference) -> ObjectReference {
+    object.get_forwarded_object().unwrap_or(object)
+}
+
 #[no_mangle]
 pub extern "C" fn is_mapped_address(addr: Address) -> bool {
     memory_manager::is_mapped_address(addr)
@@ -266,18 +279,122 @@ pub extern "C" fn mmtk_harness_end_impl() {
     memory_manager::harness_end(&SINGLETON);
 }
 
+// Inline fast-paths, one bit per tier. These need to match `MMTK_FASTPATH_*` in mmtk.h.
+const FASTPATH_INTERPRETER: u8 = 1;
+const FASTPATH_C1: u8 = 1 << 1;
+const FASTPATH_C2: u8 = 1 << 2;
+const FASTPATH_ALL: u8 = FASTPATH_INTERPRETER | FASTPATH_C1 | FASTPATH_C2;
+
+/// Tiers that generate the inline allocation fast-path.
+static ALLOCATION_FASTPATHS: AtomicU8 = AtomicU8::new(FASTPATH_ALL);
+/// Tiers that generate the inline barrier fast-path.
+static BARRIER_FASTPATHS: AtomicU8 = AtomicU8::new(FASTPATH_ALL);
+/// Count barrier and allocation slow-path calls, per compiled site and per thread.
+static COUNT_SLOW_PATHS: AtomicBool = AtomicBool::new(false);
+/// In nursery GCs, skip the stack frames that have not run since the last GC.
+static PARTIAL_STACK_SCANNING: AtomicBool = AtomicBool::new(false);
+/// Defer fixing the relocations of nmethods that are not on any stack to their next entry.
+static NMETHOD_ENTRY_BARRIERS: AtomicBool = AtomicBool::new(false);
+/// How many times the threads that stop and start the world spin on a state change before they block.
+static STW_SPIN_ITERATIONS: AtomicUsize = AtomicUsize::new(0);
+
+// Barrier value filters. These need to match `MMTK_BARRIER_FILTER_*` in mmtk.h.
+const BARRIER_FILTER_NULL: u8 = 1;
+const BARRIER_FILTER_TARGET: u8 = 1 << 1;
+const BARRIER_FILTER_ALL: u8 = BARRIER_FILTER_NULL | BARRIER_FILTER_TARGET;
+
+/// Stored values that the barrier skips. None by default.
+static BARRIER_FILTERS: AtomicU8 = AtomicU8::new(0);
+
+/// Parse a comma-separated list of tiers, e.g. `interpreter,c2`, `all` or `none`.
+fn parse_fast_paths(value: &str) -> Option<u8> {
+    value.split(',').try_fold(0, |mask, tier| match tier {
+        "interpreter" => Some(mask | FASTPATH_INTERPRETER),
+        "c1" => Some(mask | FASTPATH_C1),
+        "c2" => Some(mask | FASTPATH_C2),
+        "all" => Some(mask | FASTPATH_ALL),
+        "none" => Some(mask),
+        _ => None,
+    })
+}
+
+/// Parse a comma-separated list of barrier filters, e.g. `null,target`, `all` or `none`.
+fn parse_barrier_filters(value: &str) -> Option<u8> {
+    value.split(',').try_fold(0, |mask, filter| match filter {
+        "null" => Some(mask | BARRIER_FILTER_NULL),
+        "target" => Some(mask | BARRIER_FILTER_TARGET),
+        "all" => Some(mask | BARRIER_FILTER_ALL),
+        "none" => Some(mask),
+        _ => None,
+    })
+}
+
+/// Parse a boolean option into `option`. Returns false if `value` is not `true` or `false`.
+fn parse_bool_option(value: &str, option: &AtomicBool) -> bool {
+    match value.parse::<bool>() {
+        Ok(enabled) => {
+            option.store(enabled, Ordering::Relaxed);
+            true
+        }
+        Err(_) => false,
+    }
+}
+
+/// Set an option that belongs to the binding rather than mmtk-core.
+/// Returns `None` if `name` is not a binding option.
+fn process_binding_option(name: &str, value: &str) -> Option<bool> {
+    let fast_paths = match name {
+        "openjdk_allocation_fastpath" => &ALLOCATION_FASTPATHS,
+        "openjdk_barrier_fastpath" => &BARRIER_FASTPATHS,
+        "openjdk_count_slow_paths" => return Some(parse_bool_option(value, &COUNT_SLOW_PATHS)),
+        "openjdk_partial_stack_scanning" => {
+            return Some(parse_bool_option(value, &PARTIAL_STACK_SCANNING))
+        }
+        "openjdk_nmethod_entry_barriers" => {
+            return Some(parse_bool_option(value, &NMETHOD_ENTRY_BARRIERS))
+        }
+        "openjdk_stw_spin_iterations" => {
+            return Some(match value.parse::<usize>() {
+                Ok(iterations) => {
+                    STW_SPIN_ITERATIONS.store(iterations, Ordering::Relaxed);
+                    true
+                }
+                Err(_) => false,
+            })
+        }
+        "openjdk_barrier_filter" => {
+            return Some(match parse_barrier_filters(value) {
+                Some(mask) => {
+                    BARRIER_FILTERS.store(mask, Ordering::Relaxed);
+                    true
+                }
+                None => false,
+            })
+        }
+        _ => return None,
+    };
+    Some(match parse_fast_paths(value) {
+        Some(mask) => {
+            fast_paths.store(mask, Ordering::Relaxed);
+            true
+        }
+        None => false,
+    })
+}
+
 #[no_mangle]
 // We trust the name/value pointer is valid.
 #[allow(clippy::not_unsafe_ptr_arg_deref)]
 pub extern "C" fn process(name: *const c_char, value: *const c_char) -> bool {
     let name_str: &CStr = unsafe { CStr::from_ptr(name) };
     let value_str: &CStr = unsafe { CStr::from_ptr(value) };
+    let name_str = name_str.to_str().unwrap();
+    let value_str = value_str.to_str().unwrap();
+    if let Some(success) = process_binding_option(name_str, value_str) {
+        return success;
+    }
     let mut builder = BUILDER.lock().unwrap();
-    memory_manager::process(
-        &mut builder,
-        name_str.to_str().unwrap(),
-        value_str.to_str().unwrap(),
-    )
+    memory_manager::process(&mut builder, name_str, value_str)
 }
 
 #[no_mangle]
@@ -285,8 +402,62 @@ pub extern "C" fn process(name: *const c_char, value: *const c_char) -> bool {
 #[allow(clippy::not_unsafe_ptr_arg_deref)]
 pub extern "C" fn process_bulk(options: *const c_char) -> bool {
     let options_str: &CStr = unsafe { CStr::from_ptr(options) };
+    // Binding options are consumed here. Everything else is passed on to mmtk-core.
+    let mut mmtk_options = vec![];
+    for opt in options_str.to_str().unwrap().split_ascii_whitespace() {
+        let binding_option = opt
+            .split_once('=')
+            .and_then(|(name, value)| process_binding_option(name, value));
+        match binding_option {
+            Some(false) => return false,
+            Some(true) => {}
+            None => mmtk_options.push(opt),
+        }
+    }
     let mut builder = BUILDER.lock().unwrap();
-    memory_manager::process_bulk(&mut builder, options_str.to_str().unwrap())
+    memory_manager::process_bulk(&mut builder, &mmtk_options.join(" "))
+}
+
+/// Tiers (`MMTK_FASTPATH_*` bits) that generate the inline allocation fast-path.
+#[no_mangle]
+pub extern "C" fn mmtk_allocation_fast_paths() -> u8 {
+    ALLOCATION_FASTPATHS.load(Ordering::Relaxed)
+}
+
+/// Tiers (`MMTK_FASTPATH_*` bits) that generate the inline barrier fast-path.
+#[no_mangle]
+pub extern "C" fn mmtk_barrier_fast_paths() -> u8 {
+    BARRIER_FASTPATHS.load(Ordering::Relaxed)
+}
+
+/// Whether the slow-path counters are enabled.
+#[no_mangle]
+pub extern "C" fn mmtk_count_slow_paths() -> bool {
+    COUNT_SLOW_PATHS.load(Ordering::Relaxed)
+}
+
+/// Whether stack watermarks are used to skip unchanged frames in nursery GCs.
+#[no_mangle]
+pub extern "C" fn mmtk_partial_stack_scanning() -> bool {
+    PARTIAL_STACK_SCANNING.load(Ordering::Relaxed)
+}
+
+/// Whether compiled methods have entry barriers that fix their relocations after a GC.
+#[no_mangle]
+pub extern "C" fn mmtk_nmethod_entry_barriers() -> bool {
+    NMETHOD_ENTRY_BARRIERS.load(Ordering::Relaxed)
+}
+
+/// How many times the stop-the-world handoffs spin before blocking.
+#[no_mangle]
+pub extern "C" fn mmtk_stw_spin_iterations() -> usize {
+    STW_SPIN_ITERATIONS.load(Ordering::Relaxed)
+}
+
+/// Stored values (`MMTK_BARRIER_FILTER_*` bits) that the barrier skips.
+#[no_mangle]
+pub extern "C" fn mmtk_barrier_filters() -> u8 {
+    BARRIER_FILTERS.load(Ordering::Relaxed)
 }
 
 #[no_mangle]
@@ -348,6 +519,20 @@ pub extern "C" fn mmtk_object_reference_write_slow(
         .object_reference_write_slow(src, slot, target);
 }
 
+/// Slot-based post-barrier, for a store whose source object is unknown.
+/// The slot is remembered as a one-slot memory region.
+#[no_mangle]
+pub extern "C" fn mmtk_object_reference_slot_write_post(
+    mutator: &'static mut Mutator<OpenJDK>,
+    slot: Address,
+    _target: ObjectReference,
+) {
+    let region = slot..slot + (1usize << LOG_BYTES_IN_ADDRESS);
+    mutator
+        .barrier()
+        .memory_region_copy_post(region.clone(), region);
+}
+
 /// Array-copy pre-barrier
 #[no_mangle]
 pub extern "C" fn mmtk_array_copy_pre(
@@ -416,24 +601,11 @@ pub extern "C" fn mmtk_register_nmethod(nm: Address) {
         Some(slots) => slots,
         _ => return,
     };
-    let mut roots = crate::CODE_CACHE_ROOTS.lock().unwrap();
-    // Relaxed add instead of `fetch_add`, since we've already acquired the lock.
-    crate::CODE_CACHE_ROOTS_SIZE.store(
-        crate::CODE_CACHE_ROOTS_SIZE.load(Ordering::Relaxed) + slots.len(),
-        Ordering::Relaxed,
-    );
-    roots.insert(nm, slots);
+    crate::CODE_CACHE_ROOTS.register(nm, slots);
 }
 
 /// Unregister a nmethod.
 #[no_mangle]
 pub extern "C" fn mmtk_unregister_nmethod(nm: Address) {
-    let mut roots = crate::CODE_CACHE_ROOTS.lock().unwrap();
-    if let Some(slots) = roots.remove(&nm) {
-        // Relaxed sub instead of `fetch_sub`, since we've already acquired the lock.
-        crate::CODE_CACHE_ROOTS_SIZE.store(
-            crate::CODE_CACHE_ROOTS_SIZE.load(Ordering::Relaxed) - slots.len(),
-            Ordering::Relaxed,
-        );
-    }
+    crate::CODE_CACHE_ROOTS.unregister(nm);
 }
@@ -0,0 +1,77 @@
+use std::collections::{HashMap, HashSet};
+use std::sync::Mutex;
+
+use mmtk::util::Address;
+
+/// The number of shards of the code cache roots.
+/// Each shard has its own lock, and its roots are scanned by a separate work packet.
+pub const CODE_CACHE_ROOTS_SHARDS: usize = 16;
+
+#[derive(Default)]
+struct Shard {
+    /// The oop slots of each registered nmethod
+    roots: HashMap<Address, Vec<Address>>,
+    /// The nmethods registered since the last GC.
+    /// Only these nmethods may reference nursery objects: every GC promotes the objects referenced by the others.
+    young: HashSet<Address>,
+}
+
+/// The oop slots of all the nmethods in the CodeCache, sharded by nmethod address.
+/// Registering and unregistering an nmethod only locks its own shard.
+pub struct CodeCacheRoots {
+    shards: Vec<Mutex<Shard>>,
+}
+
+impl CodeCacheRoots {
+    pub fn new() -> Self {
+        Self {
+            shards: (0..CODE_CACHE_ROOTS_SHARDS)
+                .map(|_| Mutex::new(Shard::default()))
+                .collect(),
+        }
+    }
+
+    fn shard(&self, nm: Address) -> &Mutex<Shard> {
+        // nmethods are at least CodeEntryAlignment (32 bytes) apart, so drop the low bits.
+        &self.shards[(nm.as_usize() >> 5) % CODE_CACHE_ROOTS_SHARDS]
+    }
+
+    pub fn register(&self, nm: Address, slots: Vec<Address>) {
+        let mut shard = self.shard(nm).lock().unwrap();
+        shard.roots.insert(nm, slots);
+        shard.young.insert(nm);
+    }
+
+    pub fn unregister(&self, nm: Address) {
+        let mut shard = self.shard(nm).lock().unwrap();
+        shard.roots.remove(&nm);
+        shard.young.remove(&nm);
+    }
+
+    /// Call `f` with each nmethod in the shard `index` and its oop slots.
+    /// If `young_only` is true, only visit the nmethods registered since the last GC.
+    pub fn for_each_nmethod(
+        &self,
+        index: usize,
+        young_only: bool,
+        mut f: impl FnMut(Address, &[Address]),
+    ) {
+        let shard = self.shards[index].lock().unwrap();
+        if young_only {
+            for nm in shard.young.iter() {
+                f(*nm, &shard.roots[nm]);
+            }
+        } else {
+            for (nm, slots) in shard.roots.iter() {
+                f(*nm, slots);
+            }
+        }
+    }
+
+    /// Called at the end of each GC. All the objects referenced by nmethods are mature from now on.
+    pub fn end_of_gc(&self) {
+        for shard in self.shards.iter() {
+            shard.lock().unwrap().young.clear();
+        }
+    }
+}
@@ -3,29 +3,12 @@ use mmtk::util::opaque_pointer::*;
 use mmtk::vm::{Collection, GCThreadContext, Scanning, VMBinding};
 use mmtk::{Mutator, MutatorContext};
 
+use crate::active_plan;
+use crate::OpenJDK;
 use crate::UPCALLS;
-use crate::{MutatorClosure, OpenJDK};
 
 pub struct VMCollection {}
 
-extern "C" fn report_mutator_stop<F>(mutator: *mut Mutator<OpenJDK>, callback: *mut F)
-where
-    F: FnMut(&'static mut Mutator<OpenJDK>),
-{
-    let callback: &mut F = unsafe { &mut *callback };
-    callback(unsafe { &mut *mutator });
-}
-
-fn to_mutator_closure<F>(callback: &mut F) -> MutatorClosure
-where
-    F: FnMut(&'static mut Mutator<OpenJDK>),
-{
-    MutatorClosure {
-        func: report_mutator_stop::<F> as *const _,
-        data: callback as *mut F as *mut libc::c_void,
-    }
-}
-
 const GC_THREAD_KIND_CONTROLLER: libc::c_int = 0;
 const GC_THREAD_KIND_WORKER: libc::c_int = 1;
 
@@ -34,23 +17,25 @@ impl Collection<OpenJDK> for VMCollection {
     /// the OpenJDK binding allows any MMTk GC thread to stop/start the world.
     const COORDINATOR_ONLY_STW: bool = false;
 
-    fn stop_all_mutators<F>(tls: VMWorkerThread, mut mutator_visitor: F)
+    fn stop_all_mutators<F>(tls: VMWorkerThread, mutator_visitor: F)
     where
         F: FnMut(&'static mut Mutator<OpenJDK>),
     {
-        let scan_mutators_in_safepoint =
-            <OpenJDK as VMBinding>::VMScanning::SCAN_MUTATORS_IN_SAFEPOINT;
-
         unsafe {
-            ((*UPCALLS).stop_all_mutators)(
-                tls,
-                scan_mutators_in_safepoint,
-                to_mutator_closure(&mut mutator_visitor),
-            );
+            ((*UPCALLS).stop_all_mutators)(tls);
+        }
+        // The thread list cannot change until the mutators are resumed. All the enumerations of
+        // mutators in this pause, including those for preparing and releasing them, use this snapshot.
+        active_plan::on_mutators_stopped();
+        if !<OpenJDK as VMBinding>::VMScanning::SCAN_MUTATORS_IN_SAFEPOINT {
+            active_plan::for_each_mutator(mutator_visitor);
         }
     }
 
     fn resume_mutators(tls: VMWorkerThread) {
+        active_plan::on_mutators_resumed();
+        crate::CODE_CACHE_ROOTS.end_of_gc();
+        crate::scanning::RE_SCANNING_ROOTS.store(false, std::sync::atomic::Ordering::Relaxed);
         unsafe {
             ((*UPCALLS).resume_mutators)(tls);
         }
@@ -0,0 +1,42 @@
+use std::cell::RefCell;
+use std::mem::ManuallyDrop;
+
+use mmtk::util::Address;
+
+use crate::NewBuffer;
+
+/// The number of free buffers kept by each thread.
+const MAX_FREE_BUFFERS: usize = 8;
+
+thread_local! {
+    /// The buffers released by the root-scanning closures of this thread (a GC worker), for reuse.
+    static FREE_BUFFERS: RefCell<Vec<Vec<Address>>> = RefCell::new(Vec::with_capacity(MAX_FREE_BUFFERS));
+}
+
+/// Get an empty buffer of `capacity` edges to hand over to C++, reusing a released one if possible.
+pub fn new_buffer(capacity: usize) -> NewBuffer {
+    let buf = FREE_BUFFERS
+        .with(|free| {
+            let mut free = free.borrow_mut();
+            let index = free.iter().position(|buf| buf.capacity() == capacity)?;
+            Some(free.swap_remove(index))
+        })
+        .unwrap_or_else(|| Vec::with_capacity(capacity));
+    // TODO: Use Vec::into_raw_parts() when the method is available.
+    let mut buf = ManuallyDrop::new(buf);
+    NewBuffer {
+        ptr: buf.as_mut_ptr(),
+        capacity: buf.capacity(),
+    }
+}
+
+/// Take back a buffer that C++ no longer uses. It is kept for `new_buffer` unless this thread already has enough.
+pub fn release_buffer(mut buf: Vec<Address>) {
+    buf.clear();
+    FREE_BUFFERS.with(|free| {
+        let mut free = free.borrow_mut();
+        if free.len() < MAX_FREE_BUFFERS {
+            free.push(buf);
+        }
+    });
+}
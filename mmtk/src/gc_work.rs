@@ -1,10 +1,10 @@
-use std::sync::atomic::Ordering;
-
-use super::{OpenJDK, OpenJDKEdge, UPCALLS};
+use super::{OpenJDK, OpenJDKEdge, SINGLETON, UPCALLS};
+use mmtk::memory_manager;
 use mmtk::scheduler::*;
+use mmtk::util::{Address, ObjectReference};
 use mmtk::vm::RootsWorkFactory;
 use mmtk::MMTK;
-use scanning::to_edges_closure;
+use scanning::{to_edges_closure, WORK_PACKET_CAPACITY};
 
 macro_rules! scan_roots_work {
     ($struct_name: ident, $func_name: ident) => {
@@ -28,38 +28,252 @@ macro_rules! scan_roots_work {
     };
 }
 
-scan_roots_work!(
-    ScanClassLoaderDataGraphRoots,
-    scan_class_loader_data_graph_roots
-);
+pub struct ScanClassLoaderDataGraphRoots<F: RootsWorkFactory<OpenJDKEdge>> {
+    factory: F,
+    /// Only scan the class loader data that are always alive
+    class_unloading: bool,
+}
+
+impl<F: RootsWorkFactory<OpenJDKEdge>> ScanClassLoaderDataGraphRoots<F> {
+    pub fn new(factory: F, class_unloading: bool) -> Self {
+        Self {
+            factory,
+            class_unloading,
+        }
+    }
+}
+
+impl<F: RootsWorkFactory<OpenJDKEdge>> GCWork<OpenJDK> for ScanClassLoaderDataGraphRoots<F> {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, _mmtk: &'static MMTK<OpenJDK>) {
+        unsafe {
+            ((*UPCALLS).scan_class_loader_data_graph_roots)(
+                to_edges_closure(&mut self.factory),
+                self.class_unloading,
+            );
+        }
+    }
+}
+
+/// Update the derived pointers recorded by a thread-root scan, once their bases have been forwarded.
+/// Each packet handles the derived pointers of the stacks scanned by one packet, in parallel with the others.
+pub struct UpdateDerivedPointers {
+    derived_pointers: Address,
+}
+
+impl UpdateDerivedPointers {
+    /// Schedule the update of the derived pointers returned by a thread-root scan, if there are any.
+    pub fn schedule(derived_pointers: Address) {
+        if !derived_pointers.is_zero() {
+            memory_manager::add_work_packet(
+                &SINGLETON,
+                WorkBucketStage::Release,
+                UpdateDerivedPointers { derived_pointers },
+            );
+        }
+    }
+}
+
+impl GCWork<OpenJDK> for UpdateDerivedPointers {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, _mmtk: &'static MMTK<OpenJDK>) {
+        unsafe {
+            ((*UPCALLS).update_derived_pointers)(self.derived_pointers);
+        }
+    }
+}
+
+/// Unload the classes whose class loaders died, and the nmethods that reference dead objects,
+/// once the weak roots have been processed.
+pub struct UnloadClasses;
+
+impl GCWork<OpenJDK> for UnloadClasses {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, _mmtk: &'static MMTK<OpenJDK>) {
+        unsafe {
+            ((*UPCALLS).unload_classes)();
+        }
+    }
+}
+/// Clear the claim marks of the class loader data graph, so that the next GC can claim every CLD again.
+/// The marks are cleared in the `Release` stage, in parallel with other work, rather than when the world is stopped.
+pub struct ClearClaimedCLDMarks;
+
+impl GCWork<OpenJDK> for ClearClaimedCLDMarks {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, _mmtk: &'static MMTK<OpenJDK>) {
+        unsafe {
+            ((*UPCALLS).clear_claimed_cld_marks)();
+        }
+    }
+}
+
 scan_roots_work!(ScanOopStorageSetRoots, scan_oop_storage_set_roots);
 scan_roots_work!(ScanWeakProcessorRoots, scan_weak_processor_roots);
 scan_roots_work!(ScanVMThreadRoots, scan_vm_thread_roots);
 
+/// Process the weak OopStorage roots (JNI weak globals, StringTable, ResolvedMethodTable, ...) after the transitive closure.
+/// Each packet processes the blocks it claims: slots with dead referents are cleared, and the others are forwarded.
+pub struct ProcessWeakProcessorRoots {
+    worker_id: usize,
+}
+
+impl ProcessWeakProcessorRoots {
+    pub fn new(worker_id: usize) -> Self {
+        Self { worker_id }
+    }
+}
+
+impl GCWork<OpenJDK> for ProcessWeakProcessorRoots {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, _mmtk: &'static MMTK<OpenJDK>) {
+        unsafe {
+            ((*UPCALLS).process_weak_processor_roots)(self.worker_id);
+        }
+    }
+}
+
 pub struct ScanCodeCacheRoots<F: RootsWorkFactory<OpenJDKEdge>> {
     factory: F,
+    /// The shard of `CODE_CACHE_ROOTS` scanned by this packet
+    shard: usize,
+    /// Do not report the roots, but process them with `ProcessCodeCacheRoots` after the transitive closure
+    weak: bool,
 }
 
 impl<F: RootsWorkFactory<OpenJDKEdge>> ScanCodeCacheRoots<F> {
-    pub fn new(factory: F) -> Self {
-        Self { factory }
+    pub fn new(factory: F, shard: usize, weak: bool) -> Self {
+        Self {
+            factory,
+            shard,
+            weak,
+        }
     }
 }
 
 impl<F: RootsWorkFactory<OpenJDKEdge>> GCWork<OpenJDK> for ScanCodeCacheRoots<F> {
-    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, _mmtk: &'static MMTK<OpenJDK>) {
-        // Collect all the cached roots
-        let mut edges = Vec::with_capacity(crate::CODE_CACHE_ROOTS_SIZE.load(Ordering::Relaxed));
-        for roots in (*crate::CODE_CACHE_ROOTS.lock().unwrap()).values() {
-            for r in roots {
-                edges.push(*r)
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, mmtk: &'static MMTK<OpenJDK>) {
+        // A nursery GC only needs the nmethods registered since the last GC.
+        // The other nmethods only reference mature objects, which are neither moved nor freed.
+        let young_only = mmtk.get_plan().is_current_gc_nursery();
+        // The relocations of an nmethod only need fixing if this GC may move the objects it references.
+        let mut fixup = if mmtk.get_plan().constraints().moves_objects {
+            Some(FixCodeCacheRelocations::default())
+        } else {
+            None
+        };
+        if self.weak {
+            // The thread roots may forward the slots of the nmethods on the stacks before
+            // `ProcessCodeCacheRoots` runs, so record the referents now.
+            if let Some(fixup) = fixup.as_mut() {
+                crate::CODE_CACHE_ROOTS
+                    .for_each_nmethod(self.shard, false, |nm, slots| fixup.record(nm, slots));
+            }
+            memory_manager::add_work_packet(
+                mmtk,
+                WorkBucketStage::PhantomRefClosure,
+                ProcessCodeCacheRoots {
+                    shard: self.shard,
+                    fixup: fixup.filter(|fixup| !fixup.nmethods.is_empty()),
+                },
+            );
+            return;
+        }
+        // Collect the cached roots of this shard, in packets of at most WORK_PACKET_CAPACITY edges
+        let mut edges = Vec::with_capacity(WORK_PACKET_CAPACITY);
+        crate::CODE_CACHE_ROOTS.for_each_nmethod(self.shard, young_only, |nm, slots| {
+            if let Some(fixup) = fixup.as_mut() {
+                fixup.record(nm, slots);
+            }
+            for r in slots {
+                edges.push(*r);
+                if edges.len() == WORK_PACKET_CAPACITY {
+                    let full =
+                        std::mem::replace(&mut edges, Vec::with_capacity(WORK_PACKET_CAPACITY));
+                    self.factory.create_process_edge_roots_work(full);
+                }
+            }
+        });
+        if !edges.is_empty() {
+            self.factory.create_process_edge_roots_work(edges);
+        }
+        if let Some(fixup) = fixup {
+            if !fixup.nmethods.is_empty() {
+                memory_manager::add_work_packet(mmtk, WorkBucketStage::Release, fixup);
             }
         }
-        // Create work packet
-        self.factory.create_process_edge_roots_work(edges);
         // Use the following code to scan CodeCache directly, instead of scanning the "remembered set".
         // unsafe {
         //     ((*UPCALLS).scan_code_cache_roots)(create_process_edges_work::<E> as _);
         // }
     }
 }
+
+/// Process the code cache roots weakly, after the transitive closure of a GC that unloads classes.
+///
+/// Only the nmethods on the stacks are kept alive, by the thread roots.
+/// The slots that reference surviving objects are forwarded. The nmethods that reference
+/// dead objects are unloaded by `UnloadClasses`, which unregisters them.
+pub struct ProcessCodeCacheRoots {
+    /// The shard of `CODE_CACHE_ROOTS` processed by this packet
+    shard: usize,
+    /// The objects referenced by the nmethods of the shard when the roots were scanned
+    fixup: Option<FixCodeCacheRelocations>,
+}
+
+impl GCWork<OpenJDK> for ProcessCodeCacheRoots {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, mmtk: &'static MMTK<OpenJDK>) {
+        crate::CODE_CACHE_ROOTS.for_each_nmethod(self.shard, false, |_, slots| {
+            for slot in slots {
+                let object: ObjectReference = unsafe { slot.load() };
+                if object.is_null() || !object.is_live() {
+                    continue;
+                }
+                if let Some(forwarded) = object.get_forwarded_object() {
+                    unsafe { slot.store(forwarded) };
+                }
+            }
+        });
+        if let Some(fixup) = self.fixup.take() {
+            memory_manager::add_work_packet(mmtk, WorkBucketStage::Release, fixup);
+        }
+    }
+}
+
+/// Fix the oop relocations of the nmethods whose oops were moved by this GC.
+///
+/// `ScanCodeCacheRoots` records the objects referenced by each nmethod when it scans the roots.
+/// This is before any root edge is processed, as root edges are processed in the `Closure` stage.
+/// The nmethods unloaded by this GC are skipped by the upcall.
+/// After the GC, an nmethod needs fixing if any of its slots now holds a different reference.
+/// The upcall patches it at once if partial stack scanning was used by this GC, and may otherwise
+/// defer the patching to the nmethod entry barrier.
+#[derive(Default)]
+pub struct FixCodeCacheRelocations {
+    /// Each nmethod, and the number of its slots in `slots`
+    nmethods: Vec<(Address, usize)>,
+    /// The oop slots of the nmethods, and the objects they referenced before the GC
+    slots: Vec<(Address, ObjectReference)>,
+}
+
+impl FixCodeCacheRelocations {
+    fn record(&mut self, nm: Address, slots: &[Address]) {
+        self.nmethods.push((nm, slots.len()));
+        self.slots
+            .extend(slots.iter().map(|slot| (*slot, unsafe { slot.load() })));
+    }
+}
+
+impl GCWork<OpenJDK> for FixCodeCacheRelocations {
+    fn do_work(&mut self, _worker: &mut GCWorker<OpenJDK>, mmtk: &'static MMTK<OpenJDK>) {
+        let partial_stack_scanning =
+            crate::api::mmtk_partial_stack_scanning() && mmtk.get_plan().is_current_gc_nursery();
+        let mut slots = self.slots.iter();
+        for (nm, len) in self.nmethods.iter() {
+            let mut moved = false;
+            for (slot, old) in slots.by_ref().take(*len) {
+                moved |= unsafe { slot.load::<ObjectReference>() } != *old;
+            }
+            if moved {
+                unsafe {
+                    ((*UPCALLS).fix_nmethod_relocations)(*nm, partial_stack_scanning);
+                }
+            }
+        }
+    }
+}
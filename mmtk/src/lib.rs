@@ -4,10 +4,8 @@ extern crate mmtk;
 extern crate lazy_static;
 extern crate once_cell;
 
-use std::collections::HashMap;
 use std::ops::Range;
 use std::ptr::null_mut;
-use std::sync::atomic::AtomicUsize;
 use std::sync::Mutex;
 
 use libc::{c_char, c_void, uintptr_t};
@@ -23,7 +21,9 @@ mod abi;
 pub mod active_plan;
 pub mod api;
 mod build_info;
+mod code_cache_roots;
 pub mod collection;
+mod edge_buffers;
 mod gc_work;
 pub mod object_model;
 mod object_scanning;
@@ -37,13 +37,6 @@ pub struct NewBuffer {
     pub capacity: usize,
 }
 
-/// A closure for reporting mutators.  The C++ code should pass `data` back as the last argument.
-#[repr(C)]
-pub struct MutatorClosure {
-    pub func: *const extern "C" fn(mutator: *mut Mutator<OpenJDK>, data: *mut libc::c_void),
-    pub data: *mut libc::c_void,
-}
-
 /// A closure for reporting root edges.  The C++ code should pass `data` back as the last argument.
 #[repr(C)]
 pub struct EdgesClosure {
@@ -54,17 +47,12 @@ pub struct EdgesClosure {
 
 #[repr(C)]
 pub struct OpenJDK_Upcalls {
-    pub stop_all_mutators: extern "C" fn(
-        tls: VMWorkerThread,
-        scan_mutators_in_safepoint: bool,
-        closure: MutatorClosure,
-    ),
+    pub stop_all_mutators: extern "C" fn(tls: VMWorkerThread),
     pub resume_mutators: extern "C" fn(tls: VMWorkerThread),
     pub spawn_gc_thread: extern "C" fn(tls: VMThread, kind: libc::c_int, ctx: *mut libc::c_void),
     pub block_for_gc: extern "C" fn(),
     pub out_of_memory: extern "C" fn(tls: VMThread, err_kind: AllocationError),
-    pub get_next_mutator: extern "C" fn() -> *mut Mutator<OpenJDK>,
-    pub reset_mutator_iterator: extern "C" fn(),
+    pub get_mutators: extern "C" fn(mutators: *mut Address, capacity: usize) -> usize,
     pub scan_object: extern "C" fn(trace: *mut c_void, object: ObjectReference, tls: OpaquePointer),
     pub dump_object: extern "C" fn(object: ObjectReference),
     pub get_object_size: extern "C" fn(object: ObjectReference) -> usize,
@@ -78,12 +66,22 @@ pub struct OpenJDK_Upcalls {
     pub referent_offset: extern "C" fn() -> i32,
     pub discovered_offset: extern "C" fn() -> i32,
     pub dump_object_string: extern "C" fn(object: ObjectReference) -> *const c_char,
-    pub scan_all_thread_roots: extern "C" fn(closure: EdgesClosure),
-    pub scan_thread_roots: extern "C" fn(closure: EdgesClosure, tls: VMMutatorThread),
+    pub scan_all_thread_roots: extern "C" fn(closure: EdgesClosure) -> Address,
+    pub scan_thread_roots:
+        extern "C" fn(closure: EdgesClosure, tls: VMMutatorThread, partial: bool) -> Address,
+    pub update_derived_pointers: extern "C" fn(derived_pointers: Address),
     pub scan_code_cache_roots: extern "C" fn(closure: EdgesClosure),
-    pub scan_class_loader_data_graph_roots: extern "C" fn(closure: EdgesClosure),
+    pub fix_nmethod_relocations: extern "C" fn(nm: Address, partial_stack_scanning: bool),
+    pub scan_class_loader_data_graph_roots:
+        extern "C" fn(closure: EdgesClosure, class_unloading: bool),
+    pub scan_class_loader_data: extern "C" fn(cld: Address, closure: EdgesClosure),
+    pub class_loader_data_of: extern "C" fn(object: ObjectReference) -> Address,
+    pub class_unloading_enabled: extern "C" fn() -> bool,
+    pub unload_classes: extern "C" fn(),
+    pub clear_claimed_cld_marks: extern "C" fn(),
     pub scan_oop_storage_set_roots: extern "C" fn(closure: EdgesClosure),
     pub scan_weak_processor_roots: extern "C" fn(closure: EdgesClosure),
+    pub process_weak_processor_roots: extern "C" fn(worker_id: usize),
     pub scan_vm_thread_roots: extern "C" fn(closure: EdgesClosure),
     pub number_of_mutators: extern "C" fn() -> usize,
     pub schedule_finalizer: extern "C" fn(),
@@ -148,8 +146,5 @@ pub static MMTK_MARK_COMPACT_HEADER_RESERVED_IN_BYTES: usize =
 
 lazy_static! {
     /// A global storage for all the cached CodeCache root pointers
-    static ref CODE_CACHE_ROOTS: Mutex<HashMap<Address, Vec<Address>>> = Mutex::new(HashMap::new());
+    static ref CODE_CACHE_ROOTS: code_cache_roots::CodeCacheRoots = code_cache_roots::CodeCacheRoots::new();
 }
-
-/// A counter tracking the total size of the `CODE_CACHE_ROOTS`.
-static CODE_CACHE_ROOTS_SIZE: AtomicUsize = AtomicUsize::new(0);
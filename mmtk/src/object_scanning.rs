@@ -1,11 +1,118 @@
 use super::abi::*;
-use super::{OpenJDKEdge, UPCALLS};
+use super::{EdgesClosure, NewBuffer, OpenJDKEdge, UPCALLS};
+use crate::scanning::{CLASS_UNLOADING, CLD_SCAN_EPOCH};
 use mmtk::util::constants::*;
 use mmtk::util::opaque_pointer::*;
 use mmtk::util::{Address, ObjectReference};
 use mmtk::vm::EdgeVisitor;
+use std::cell::RefCell;
+use std::ops::Range;
+use std::sync::atomic::Ordering;
 use std::{mem, slice};
 
+/// The number of slots checked together for null by `visit_slice`.
+const NULL_CHECK_CHUNK: usize = 8;
+
+/// Visit the non-null slots of a contiguous range of slots, such as an oop map block or the elements of an object array.
+/// A null slot needs neither tracing nor updating, and sparse arrays are mostly null. The slots are OR-ed together
+/// in chunks, which the compiler vectorizes, so a chunk of nulls is skipped with a single branch.
+#[inline]
+fn visit_slice(slots: Range<Address>, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
+    let len = (slots.end - slots.start) >> LOG_BYTES_IN_ADDRESS;
+    let values = unsafe { slice::from_raw_parts(slots.start.to_ptr::<usize>(), len) };
+    let mut chunks = values.chunks_exact(NULL_CHECK_CHUNK);
+    let mut edge = slots.start;
+    for chunk in &mut chunks {
+        if chunk.iter().fold(0, |acc, value| acc | value) != 0 {
+            visit_non_null(edge, chunk, closure);
+        }
+        edge += NULL_CHECK_CHUNK << LOG_BYTES_IN_ADDRESS;
+    }
+    visit_non_null(edge, chunks.remainder(), closure);
+}
+
+#[inline(always)]
+fn visit_non_null(start: Address, values: &[usize], closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
+    for (i, value) in values.iter().enumerate() {
+        if *value != 0 {
+            closure.visit_edge(start + (i << LOG_BYTES_IN_ADDRESS));
+        }
+    }
+}
+
+/// The number of entries of the per-thread cache of visited class loader data.
+const VISITED_CLDS_CACHE_SIZE: usize = 64;
+
+thread_local! {
+    /// The class loader data recently visited by this thread, in the root scan epoch of the first field.
+    /// Most objects belong to a few class loaders, so this skips most of the upcalls to claim them.
+    static VISITED_CLDS: RefCell<(usize, [Address; VISITED_CLDS_CACHE_SIZE])> =
+        RefCell::new((0, [Address::ZERO; VISITED_CLDS_CACHE_SIZE]));
+}
+
+extern "C" fn visit_edges_and_reuse_buffer<EV: EdgeVisitor<OpenJDKEdge>>(
+    ptr: *mut Address,
+    length: usize,
+    capacity: usize,
+    closure: *mut EV,
+) -> NewBuffer {
+    if ptr.is_null() {
+        // The CLDs hold few oops. The buffer is released by the closure.
+        return crate::edge_buffers::new_buffer(64);
+    }
+    let closure: &mut EV = unsafe { &mut *closure };
+    for edge in unsafe { slice::from_raw_parts(ptr, length) } {
+        closure.visit_edge(*edge);
+    }
+    NewBuffer { ptr, capacity }
+}
+
+/// Visit the oops of the class loader data `cld`, which is kept alive by the object being scanned.
+/// Only the GCs that unload classes trace the class loader data. Each CLD is visited by the first thread that claims it.
+#[inline]
+fn visit_class_loader_data(cld: Address, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
+    if !CLASS_UNLOADING.load(Ordering::Relaxed) || cld.is_zero() {
+        return;
+    }
+    let epoch = CLD_SCAN_EPOCH.load(Ordering::Relaxed);
+    let visited = VISITED_CLDS.with(|visited| {
+        let mut visited = visited.borrow_mut();
+        if visited.0 != epoch {
+            *visited = (epoch, [Address::ZERO; VISITED_CLDS_CACHE_SIZE]);
+        }
+        let index = (cld.as_usize() >> LOG_BYTES_IN_ADDRESS) % VISITED_CLDS_CACHE_SIZE;
+        mem::replace(&mut visited.1[index], cld) == cld
+    });
+    if !visited {
+        visit_class_loader_data_slow(cld, closure);
+    }
+}
+
+#[inline(never)]
+fn visit_class_loader_data_slow<EV: EdgeVisitor<OpenJDKEdge>>(cld: Address, closure: &mut EV) {
+    let edges_closure = EdgesClosure {
+        func: visit_edges_and_reuse_buffer::<EV> as *const _,
+        data: closure as *mut EV as *mut libc::c_void,
+    };
+    unsafe {
+        ((*UPCALLS).scan_class_loader_data)(cld, edges_closure);
+    }
+}
+
+#[inline]
+fn klass_class_loader_data(oop: Oop) -> Address {
+    unsafe { mem::transmute(oop.klass.class_loader_data) }
+}
+
+/// The class loader data referenced by a java.lang.Class or java.lang.ClassLoader object
+#[inline]
+fn class_loader_data_of(oop: Oop) -> Address {
+    if !CLASS_UNLOADING.load(Ordering::Relaxed) {
+        return Address::ZERO;
+    }
+    unsafe { ((*UPCALLS).class_loader_data_of)(mem::transmute(oop)) }
+}
+
 trait OopIterate: Sized {
     fn oop_iterate(&self, oop: Oop, closure: &mut impl EdgeVisitor<OpenJDKEdge>);
 }
@@ -14,16 +121,17 @@ impl OopIterate for OopMapBlock {
     #[inline]
     fn oop_iterate(&self, oop: Oop, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
         let start = oop.get_field_address(self.offset);
-        for i in 0..self.count as usize {
-            let edge = start + (i << LOG_BYTES_IN_ADDRESS);
-            closure.visit_edge(edge);
-        }
+        visit_slice(
+            start..start + ((self.count as usize) << LOG_BYTES_IN_ADDRESS),
+            closure,
+        );
     }
 }
 
 impl OopIterate for InstanceKlass {
     #[inline]
     fn oop_iterate(&self, oop: Oop, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
+        visit_class_loader_data(klass_class_loader_data(oop), closure);
         let oop_maps = self.nonstatic_oop_maps();
         for map in oop_maps {
             map.oop_iterate(oop, closure)
@@ -35,6 +143,8 @@ impl OopIterate for InstanceMirrorKlass {
     #[inline]
     fn oop_iterate(&self, oop: Oop, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
         self.instance_klass.oop_iterate(oop, closure);
+        // The class loader data of the class that this mirror represents
+        visit_class_loader_data(class_loader_data_of(oop), closure);
         // if (Devirtualizer::do_metadata(closure)) {
         //     Klass* klass = java_lang_Class::as_Klass(obj);
         //     // We'll get NULL for primitive mirrors.
@@ -63,12 +173,9 @@ impl OopIterate for InstanceMirrorKlass {
         // }
 
         // static fields
-        let start: *const Oop = Self::start_of_static_fields(oop).to_ptr::<Oop>();
+        let start = Self::start_of_static_fields(oop);
         let len = Self::static_oop_field_count(oop);
-        let slice = unsafe { slice::from_raw_parts(start, len as _) };
-        for oop in slice {
-            closure.visit_edge(Address::from_ref(oop as &Oop));
-        }
+        visit_slice(start..start + (len << LOG_BYTES_IN_ADDRESS), closure);
     }
 }
 
@@ -76,6 +183,7 @@ impl OopIterate for InstanceClassLoaderKlass {
     #[inline]
     fn oop_iterate(&self, oop: Oop, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
         self.instance_klass.oop_iterate(oop, closure);
+        visit_class_loader_data(class_loader_data_of(oop), closure);
         // if (Devirtualizer::do_metadata(closure)) {
         //     ClassLoaderData* cld = java_lang_ClassLoader::loader_data(obj);
         //     // cld can be null if we have a non-registered class loader.
@@ -89,10 +197,11 @@ impl OopIterate for InstanceClassLoaderKlass {
 impl OopIterate for ObjArrayKlass {
     #[inline]
     fn oop_iterate(&self, oop: Oop, closure: &mut impl EdgeVisitor<OpenJDKEdge>) {
+        visit_class_loader_data(klass_class_loader_data(oop), closure);
         let array = unsafe { oop.as_array_oop() };
-        for oop in unsafe { array.data::<Oop>(BasicType::T_OBJECT) } {
-            closure.visit_edge(Address::from_ref(oop as &Oop));
-        }
+        let data = unsafe { array.data::<Oop>(BasicType::T_OBJECT) };
+        let start = Address::from_ptr(data.as_ptr());
+        visit_slice(start..start + (data.len() << LOG_BYTES_IN_ADDRESS), closure);
     }
 }
 
@@ -1,19 +1,42 @@
 use super::gc_work::*;
 use super::{NewBuffer, OpenJDKEdge, SINGLETON, UPCALLS};
+use crate::code_cache_roots::CODE_CACHE_ROOTS_SHARDS;
+use crate::edge_buffers;
 use crate::{EdgesClosure, OpenJDK};
 use mmtk::memory_manager;
-use mmtk::scheduler::WorkBucketStage;
+use mmtk::scheduler::{GCWork, WorkBucketStage};
 use mmtk::util::opaque_pointer::*;
 use mmtk::util::{Address, ObjectReference};
 use mmtk::vm::{EdgeVisitor, RootsWorkFactory, Scanning};
 use mmtk::Mutator;
 use mmtk::MutatorContext;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 
 pub struct VMScanning {}
 
-const WORK_PACKET_CAPACITY: usize = 4096;
+/// The number of root edges in a work packet, for the roots reported in bulk (OopStorages, class loader data, code cache).
+pub(crate) const WORK_PACKET_CAPACITY: usize = 4096;
 
-extern "C" fn report_edges_and_renew_buffer<F: RootsWorkFactory<OpenJDKEdge>>(
+/// The number of root edges in a work packet for thread stacks.
+/// A thread has few roots, but their referents are often the heads of large structures.
+/// Smaller packets spread the transitive closure from a deep stack over more workers.
+pub(crate) const THREAD_ROOTS_PACKET_CAPACITY: usize = 512;
+
+/// Whether the roots are being scanned for the second time in the current GC, to update them after objects are moved.
+pub(crate) static RE_SCANNING_ROOTS: AtomicBool = AtomicBool::new(false);
+
+/// Whether the current GC unloads classes. If so, only the class loader data that are always alive are roots,
+/// and the others are reached through the objects of their classes.
+/// Nursery GCs, and all GCs with `-XX:-ClassUnloading`, do not unload classes.
+pub(crate) static CLASS_UNLOADING: AtomicBool = AtomicBool::new(false);
+
+/// Incremented for each root scan, which starts a new round of claiming class loader data.
+pub(crate) static CLD_SCAN_EPOCH: AtomicUsize = AtomicUsize::new(0);
+
+extern "C" fn report_edges_and_renew_buffer<
+    F: RootsWorkFactory<OpenJDKEdge>,
+    const CAPACITY: usize,
+>(
     ptr: *mut Address,
     length: usize,
     capacity: usize,
@@ -24,19 +47,22 @@ extern "C" fn report_edges_and_renew_buffer<F: RootsWorkFactory<OpenJDKEdge>>(
         let factory: &mut F = unsafe { &mut *factory_ptr };
         factory.create_process_edge_roots_work(buf);
     }
-    let (ptr, _, capacity) = {
-        // TODO: Use Vec::into_raw_parts() when the method is available.
-        use std::mem::ManuallyDrop;
-        let new_vec = Vec::with_capacity(WORK_PACKET_CAPACITY);
-        let mut me = ManuallyDrop::new(new_vec);
-        (me.as_mut_ptr(), me.len(), me.capacity())
-    };
-    NewBuffer { ptr, capacity }
+    edge_buffers::new_buffer(CAPACITY)
 }
 
 pub(crate) fn to_edges_closure<F: RootsWorkFactory<OpenJDKEdge>>(factory: &mut F) -> EdgesClosure {
+    to_edges_closure_with_capacity::<F, WORK_PACKET_CAPACITY>(factory)
+}
+
+/// Like `to_edges_closure`, but each work packet holds up to `CAPACITY` root edges.
+pub(crate) fn to_edges_closure_with_capacity<
+    F: RootsWorkFactory<OpenJDKEdge>,
+    const CAPACITY: usize,
+>(
+    factory: &mut F,
+) -> EdgesClosure {
     EdgesClosure {
-        func: report_edges_and_renew_buffer::<F> as *const _,
+        func: report_edges_and_renew_buffer::<F, CAPACITY> as *const _,
         data: factory as *mut F as *mut libc::c_void,
     }
 }
@@ -59,9 +85,13 @@ impl Scanning<OpenJDK> for VMScanning {
     }
 
     fn scan_thread_roots(_tls: VMWorkerThread, mut factory: impl RootsWorkFactory<OpenJDKEdge>) {
-        unsafe {
-            ((*UPCALLS).scan_all_thread_roots)(to_edges_closure(&mut factory));
-        }
+        let derived_pointers = unsafe {
+            ((*UPCALLS).scan_all_thread_roots)(to_edges_closure_with_capacity::<
+                _,
+                THREAD_ROOTS_PACKET_CAPACITY,
+            >(&mut factory))
+        };
+        UpdateDerivedPointers::schedule(derived_pointers);
     }
 
     fn scan_thread_root(
@@ -70,22 +100,88 @@ impl Scanning<OpenJDK> for VMScanning {
         mut factory: impl RootsWorkFactory<OpenJDKEdge>,
     ) {
         let tls = mutator.get_tls();
-        unsafe {
-            ((*UPCALLS).scan_thread_roots)(to_edges_closure(&mut factory), tls);
-        }
+        // Only a nursery GC can skip the frames that have not run since the last GC:
+        // all their references point to mature objects, which a nursery GC neither moves nor frees.
+        // This relies on every GC promoting all the nursery objects that survive it, as GenCopy and
+        // GenImmix do. A plan that keeps survivors in the nursery (e.g. sticky mark bits, or aging)
+        // would leave young objects referenced by the skipped frames, and must not scan partially.
+        let partial = crate::api::mmtk_partial_stack_scanning()
+            && SINGLETON.get_plan().is_current_gc_nursery();
+        let derived_pointers = unsafe {
+            ((*UPCALLS).scan_thread_roots)(
+                to_edges_closure_with_capacity::<_, THREAD_ROOTS_PACKET_CAPACITY>(&mut factory),
+                tls,
+                partial,
+            )
+        };
+        UpdateDerivedPointers::schedule(derived_pointers);
     }
 
     fn scan_vm_specific_roots(_tls: VMWorkerThread, factory: impl RootsWorkFactory<OpenJDKEdge>) {
+        let re_scanning = RE_SCANNING_ROOTS.load(Ordering::Relaxed);
+        // Classes are unloaded by full-heap GCs, unless disabled by `-XX:-ClassUnloading`.
+        let class_unloading = !SINGLETON.get_plan().is_current_gc_nursery()
+            && unsafe { ((*UPCALLS).class_unloading_enabled)() };
+        CLASS_UNLOADING.store(class_unloading, Ordering::Relaxed);
+        // The code cache roots are weak when classes are unloaded, so that the nmethods referencing dead objects go too.
+        // The re-scan only updates the roots of the nmethods that survived.
+        let weak_code_cache_roots = class_unloading && !re_scanning;
         memory_manager::add_work_packets(
             &SINGLETON,
             WorkBucketStage::Prepare,
-            vec![
-                Box::new(ScanCodeCacheRoots::new(factory.clone())) as _,
-                Box::new(ScanClassLoaderDataGraphRoots::new(factory.clone())) as _,
-                Box::new(ScanOopStorageSetRoots::new(factory.clone())) as _, // FIXME17: Several removed roots are all put to this work packet, may cause slowdown.
-                Box::new(ScanWeakProcessorRoots::new(factory.clone())) as _,
-            ],
+            (0..CODE_CACHE_ROOTS_SHARDS)
+                .map(|shard| {
+                    Box::new(ScanCodeCacheRoots::new(
+                        factory.clone(),
+                        shard,
+                        weak_code_cache_roots,
+                    )) as Box<dyn GCWork<OpenJDK>>
+                })
+                .collect(),
         );
+        // One packet per GC worker walks the class loader data graph and the OopStorageSet.
+        // Each CLD, and each range of OopStorage blocks, is scanned by the packet that claims it.
+        let threads = *SINGLETON.get_options().threads;
+        CLD_SCAN_EPOCH.fetch_add(1, Ordering::Relaxed);
+        let mut packets: Vec<Box<dyn GCWork<OpenJDK>>> = vec![];
+        for _ in 0..threads {
+            packets.push(Box::new(ScanClassLoaderDataGraphRoots::new(
+                factory.clone(),
+                class_unloading,
+            )));
+            packets.push(Box::new(ScanOopStorageSetRoots::new(factory.clone())));
+        }
+        memory_manager::add_work_packets(&SINGLETON, WorkBucketStage::Prepare, packets);
+        memory_manager::add_work_packet(&SINGLETON, WorkBucketStage::Release, ClearClaimedCLDMarks);
+        if re_scanning {
+            // The weak roots have been processed. Update the surviving ones like strong roots.
+            memory_manager::add_work_packet(
+                &SINGLETON,
+                WorkBucketStage::Prepare,
+                ScanWeakProcessorRoots::new(factory.clone()),
+            );
+        } else {
+            // The weak roots are not traced. They are processed after the phantom references,
+            // when every object that survives the GC has been reached.
+            memory_manager::add_work_packets(
+                &SINGLETON,
+                WorkBucketStage::PhantomRefClosure,
+                (0..threads)
+                    .map(|worker_id| {
+                        Box::new(ProcessWeakProcessorRoots::new(worker_id))
+                            as Box<dyn GCWork<OpenJDK>>
+                    })
+                    .collect(),
+            );
+            if class_unloading {
+                // The first stage after the weak roots are processed
+                memory_manager::add_work_packet(
+                    &SINGLETON,
+                    WorkBucketStage::CalculateForwarding,
+                    UnloadClasses,
+                );
+            }
+        }
         if !(Self::SCAN_MUTATORS_IN_SAFEPOINT && Self::SINGLE_THREAD_MUTATOR_SCANNING) {
             memory_manager::add_work_packet(
                 &SINGLETON,
@@ -100,6 +196,7 @@ impl Scanning<OpenJDK> for VMScanning {
     }
 
     fn prepare_for_roots_re_scanning() {
+        RE_SCANNING_ROOTS.store(true, Ordering::Relaxed);
         unsafe {
             ((*UPCALLS).prepare_for_roots_re_scanning)();
         }
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This code is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 only, as
+ * published by the Free Software Foundation.
+ *
+ * This code is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * version 2 for more details (a copy is included in the LICENSE file that
+ * accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License version
+ * 2 along with this work; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Please contact Oracle, 500 Oracle Parkway, Redwood Shores, CA 94065 USA
+ * or visit www.oracle.com if you need additional information or have any
+ * questions.
+ *
+ */
+#include "precompiled.hpp"
+#include "asm/macroAssembler.inline.hpp"
+#include "interpreter/interp_masm.hpp"
+#include "mmtkBarrierSet.hpp"
+#include "mmtkBarrierSetAssembler_aarch64.hpp"
+#include "mmtkBarrierSetC1.hpp"
+#include "mmtkMutator.hpp"
+#include "mmtkSlowPathCounters.hpp"
+#include "runtime/sharedRuntime.hpp"
+#include "utilities/macros.hpp"
+#include "c1/c1_LIRAssembler.hpp"
+#include "c1/c1_MacroAssembler.hpp"
+
+#define __ masm->
+
+void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register t1, Label& slow_case) {
+  // The caller did not say which tier it generates code for. It may be the interpreter or C1.
+  eden_allocate(masm, MMTK_FASTPATH_INTERPRETER | MMTK_FASTPATH_C1, obj, var_size_in_bytes, con_size_in_bytes, t1, slow_case);
+}
+
+void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, uint8_t tiers, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register t1, Label& slow_case) {
+  assert_different_registers(obj, var_size_in_bytes, t1, rscratch1, rscratch2);
+
+  if (!MMTkFastPaths::allocation_in_all(tiers)) {
+    __ b(slow_case);
+  } else {
+    // MMTk size check. If the alloc size is larger than the allowed max size for non los,
+    // we jump to slow path and allodate with LOS in slowpath.
+    // Note that OpenJDK has a slow path check. Search for layout_helper_needs_slow_path and FastAllocateSizeLimit.
+    assert(MMTkMutatorContext::max_non_los_default_alloc_bytes != 0, "max_non_los_default_alloc_bytes hasn't been initialized");
+    size_t max_non_los_bytes = MMTkMutatorContext::max_non_los_default_alloc_bytes;
+    size_t extra_header = 0;
+    // fastpath, we only use default allocator
+    Allocator allocator = AllocatorDefault;
+    // We need to figure out which allocator we are using by querying MMTk.
+    AllocatorSelector selector = get_allocator_mapping(allocator);
+    if (selector.tag == TAG_MARK_COMPACT) extra_header = MMTK_MARK_COMPACT_HEADER_RESERVED_IN_BYTES;
+
+    if (var_size_in_bytes == noreg) {
+      // constant alloc size. If it is larger than max_non_los_bytes, we directly go to slowpath.
+      if ((size_t)con_size_in_bytes > max_non_los_bytes - extra_header) {
+        __ b(slow_case);
+        return;
+      }
+    } else {
+      // var alloc size. We compare with max_non_los_bytes and conditionally jump to slowpath.
+      __ mov(rscratch1, (uint64_t) (max_non_los_bytes - extra_header));
+      __ cmp(var_size_in_bytes, rscratch1);
+      __ br(Assembler::HS, slow_case);
+    }
+
+    if (selector.tag == TAG_MALLOC || selector.tag == TAG_LARGE_OBJECT) {
+      __ b(slow_case);
+      return;
+    }
+
+    // Calculate offsets of TLAB top and end
+    MMTkAllocatorOffsets alloc_offsets = get_tlab_top_and_end_offsets(selector);
+
+    Address cursor(rthread, alloc_offsets.tlab_top_offset);
+    Address limit(rthread, alloc_offsets.tlab_end_offset);
+
+    // obj = load lab.cursor
+    __ ldr(obj, cursor);
+    if (selector.tag == TAG_MARK_COMPACT) __ add(obj, obj, (uint64_t) extra_header);
+    // end = obj + size
+    Register end = t1;
+    if (var_size_in_bytes == noreg) {
+      __ add(end, obj, (uint64_t) con_size_in_bytes);
+    } else {
+      __ add(end, obj, var_size_in_bytes);
+    }
+    // slowpath if end < obj
+    __ cmp(end, obj);
+    __ br(Assembler::LO, slow_case);
+    // slowpath if end > lab.limit
+    __ ldr(rscratch1, limit);
+    __ cmp(end, rscratch1);
+    __ br(Assembler::HI, slow_case);
+    // lab.cursor = end
+    __ str(end, cursor);
+
+    bool enable_global_alloc_bit = false;
+    #ifdef MMTK_ENABLE_GLOBAL_ALLOC_BIT
+    enable_global_alloc_bit = true;
+    #endif
+    if (enable_global_alloc_bit || selector.tag == TAG_MARK_COMPACT) {
+      // t1 (end) is free from here.
+      // t1 = 1 << ((obj >> 3) & 7)
+      __ ubfx(rscratch1, obj, 3, 3);
+      __ mov(t1, 1);
+      __ lslv(t1, t1, rscratch1);
+      // rscratch2 = ALLOC_BIT_BASE_ADDRESS + (obj >> 6)
+      __ lsr(rscratch1, obj, 6);
+      __ mov(rscratch2, (uint64_t) ALLOC_BIT_BASE_ADDRESS);
+      __ add(rscratch2, rscratch2, rscratch1);
+      // store-byte (load-byte rscratch2) | t1
+      __ ldrb(rscratch1, Address(rscratch2));
+      __ orr(rscratch1, rscratch1, t1);
+      __ strb(rscratch1, Address(rscratch2));
+    }
+
+    // BarrierSetAssembler::incr_allocated_bytes
+    __ ldr(rscratch1, Address(rthread, in_bytes(JavaThread::allocated_bytes_offset())));
+    if (var_size_in_bytes->is_valid()) {
+      __ add(rscratch1, rscratch1, var_size_in_bytes);
+    } else {
+      __ add(rscratch1, rscratch1, (uint64_t) con_size_in_bytes);
+    }
+    __ add(rscratch1, rscratch1, (uint64_t) extra_header);
+    __ str(rscratch1, Address(rthread, in_bytes(JavaThread::allocated_bytes_offset())));
+  }
+}
+
+#undef __
+
+#define __ sasm->
+
+void MMTkBarrierSetAssembler::generate_c1_write_barrier_runtime_stub(StubAssembler* sasm) const {
+  // See also void G1BarrierSetAssembler::generate_c1_post_barrier_runtime_stub(StubAssembler* sasm)
+  __ prologue("mmtk_write_barrier", false);
+
+  __ push_call_clobbered_registers();
+
+  // Parameters are addressed from rfp, so they can be loaded after the registers are pushed.
+  __ load_parameter(0, c_rarg0);
+  __ load_parameter(1, c_rarg1);
+  __ load_parameter(2, c_rarg2);
+
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_C1)) {
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
+  } else {
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
+  }
+
+  __ pop_call_clobbered_registers();
+
+  __ epilogue();
+}
+
+#undef __
+
+#define __ ce->masm()->
+
+void MMTkBarrierSetAssembler::generate_c1_write_barrier_stub_call(LIR_Assembler* ce, MMTkC1BarrierStub* stub) {
+  MMTkBarrierSetC1* bs = (MMTkBarrierSetC1*) BarrierSet::barrier_set()->barrier_set_c1();
+  __ bind(*stub->entry());
+  assert(stub->new_val->is_register(), "Precondition");
+  Register new_val = stub->new_val->as_pointer_register();
+  if (MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET)) {
+    // if ((uintptr_t) new_val - heap_start >= heap_extent) skip;
+    __ mov(rscratch1, MMTkFastPaths::heap_start());
+    __ sub(rscratch1, new_val, rscratch1);
+    __ mov(rscratch2, MMTkFastPaths::heap_extent());
+    __ cmp(rscratch1, rscratch2);
+    __ br(Assembler::HS, *stub->continuation());
+  } else if (MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)) {
+    // if (new_val == NULL) skip;
+    __ cbz(new_val, *stub->continuation());
+  }
+  if (stub->site != NULL) {
+    __ lea(rscratch2, ExternalAddress(stub->site->count_addr()));
+    __ increment(Address(rscratch2));
+  }
+  assert(stub->src->is_register(), "Precondition");
+  assert(stub->slot->is_register(), "Precondition");
+  ce->store_parameter(stub->src->as_pointer_register(), 0);
+  ce->store_parameter(stub->slot->as_pointer_register(), 1);
+  ce->store_parameter(new_val, 2);
+  __ far_call(RuntimeAddress(bs->_write_barrier_c1_runtime_code_blob->code_begin()));
+  __ b(*stub->continuation());
+}
+
+#undef __
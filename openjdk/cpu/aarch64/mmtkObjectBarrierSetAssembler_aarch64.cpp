@@ -0,0 +1,84 @@
+#include "precompiled.hpp"
+#include "mmtkObjectBarrier.hpp"
+#include "runtime/interfaceSupport.inline.hpp"
+
+#define __ masm->
+
+void MMTkObjectBarrierSetAssembler::object_reference_write_post(MacroAssembler* masm, DecoratorSet decorators, Address dst, Register val, Register tmp1, Register tmp2) const {
+  if (can_remove_barrier(decorators, val, /* skip_const_null */ true)) return;
+  Register obj = dst.base();
+  assert_different_registers(obj, tmp1, tmp2);
+  assert_different_registers(tmp1, tmp2, c_rarg0, c_rarg1);
+  // The object and the slot may still be used after the post barrier.
+  // See also void G1BarrierSetAssembler::g1_write_barrier_post
+  RegSet saved = RegSet::of(obj);
+  if (dst.index() != noreg) saved += RegSet::of(dst.index());
+  if (val != noreg) saved += RegSet::of(val);
+
+  Label done;
+  if (val != noreg && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET)) {
+    assert_different_registers(val, tmp1, tmp2);
+    // if ((uintptr_t) val - heap_start >= heap_extent) goto done;
+    __ mov(tmp2, (uint64_t) MMTkFastPaths::heap_start());
+    __ sub(tmp1, val, tmp2);
+    __ mov(tmp2, (uint64_t) MMTkFastPaths::heap_extent());
+    __ cmp(tmp1, tmp2);
+    __ br(Assembler::HS, done);
+  } else if (val != noreg && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)) {
+    // if (val == NULL) goto done;
+    __ cbz(val, done);
+  }
+
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_INTERPRETER)) {
+    // tmp1 = load-byte (SIDE_METADATA_BASE_ADDRESS + (obj >> 6));
+    __ lsr(tmp1, obj, 6);
+    __ mov(tmp2, (uint64_t) SIDE_METADATA_BASE_ADDRESS);
+    __ ldrb(tmp1, Address(tmp2, tmp1));
+    // tmp2 = (obj >> 3) & 7
+    __ ubfx(tmp2, obj, 3, 3);
+    // tmp1 = tmp1 >> tmp2
+    __ lsrv(tmp1, tmp1, tmp2);
+    // if ((tmp1 & 1) == 0) goto done;
+    __ tbz(tmp1, 0, done);
+  }
+
+  __ push(saved, sp);
+  // Set up the arguments in an order that does not smash `obj`, `dst` or `val`.
+  __ lea(tmp1, dst);
+  __ mov(tmp2, val == noreg ? zr : val);
+  __ mov(c_rarg0, obj);
+  __ mov(c_rarg1, tmp1);
+  __ mov(c_rarg2, tmp2);
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_INTERPRETER)) {
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
+  } else {
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
+  }
+  __ pop(saved, sp);
+
+  __ bind(done);
+}
+
+void MMTkObjectBarrierSetAssembler::arraycopy_epilogue(MacroAssembler* masm, DecoratorSet decorators, bool is_oop,
+                                                       Register start, Register count, Register tmp, RegSet saved_regs) {
+  // See also void G1BarrierSetAssembler::gen_write_ref_array_post_barrier
+  const bool dest_uninitialized = (decorators & IS_DEST_UNINITIALIZED) != 0;
+  if (is_oop && !dest_uninitialized) {
+    assert_different_registers(start, count);
+    __ push(saved_regs, sp);
+    // The source is not used by the post barrier.
+    if (count == c_rarg1) {
+      assert(start != c_rarg2, "smashed arg");
+      __ mov(c_rarg2, count);
+      __ mov(c_rarg1, start);
+    } else {
+      __ mov(c_rarg1, start);
+      __ mov(c_rarg2, count);
+    }
+    __ mov(c_rarg0, zr);
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_array_copy_post_call), 3);
+    __ pop(saved_regs, sp);
+  }
+}
+
+#undef __
@@ -28,6 +28,7 @@
 #include "mmtkBarrierSetAssembler_riscv.hpp"
 #include "mmtkBarrierSetC1.hpp"
 #include "mmtkMutator.hpp"
+#include "mmtkSlowPathCounters.hpp"
 #include "runtime/sharedRuntime.hpp"
 #include "utilities/macros.hpp"
 #include "c1/c1_LIRAssembler.hpp"
@@ -36,12 +37,17 @@
 #define __ masm->
 
 void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register tmp1, Register tmp2, Label& slow_case, bool is_far) {
+  // The caller did not say which tier it generates code for. It may be the interpreter or C1.
+  eden_allocate(masm, MMTK_FASTPATH_INTERPRETER | MMTK_FASTPATH_C1, obj, var_size_in_bytes, con_size_in_bytes, tmp1, tmp2, slow_case, is_far);
+}
+
+void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, uint8_t tiers, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register tmp1, Register tmp2, Label& slow_case, bool is_far) {
   // XXX tmp1 seems to be -1
   assert_different_registers(obj, tmp2);
   assert_different_registers(obj, var_size_in_bytes);
   assert(tmp2->is_valid(), "need temp reg");
 
-  if (!MMTK_ENABLE_ALLOCATION_FASTPATH) {
+  if (!MMTkFastPaths::allocation_in_all(tiers)) {
     __ j(slow_case);
   } else {
     //  printf("generating mmtk allocation fast path\n");
@@ -57,9 +63,7 @@ void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register obj,
     Allocator allocator = AllocatorDefault;
     // We need to figure out which allocator we are using by querying MMTk.
     AllocatorSelector selector = get_allocator_mapping(allocator);
-
-    // XXX riscv: disallow markcompact and global alloc bit for now
-    assert(selector.tag != TAG_MARK_COMPACT, "mark compact not supported for now");
+    if (selector.tag == TAG_MARK_COMPACT) extra_header = MMTK_MARK_COMPACT_HEADER_RESERVED_IN_BYTES;
 
     if (var_size_in_bytes == noreg) {
       // constant alloc size. If it is larger than max_non_los_bytes, we directly go to slowpath.
@@ -96,6 +100,7 @@ void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register obj,
 
     // obj = load lab.cursor
     __ ld(obj, cursor);
+    if (selector.tag == TAG_MARK_COMPACT) __ add(obj, obj, extra_header);
     // end = obj + size
     Register end = tmp2;
     if (var_size_in_bytes == noreg) {
@@ -113,6 +118,30 @@ void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register obj,
     // lab.cursor = end
     __ sd(end, cursor);
 
+    bool enable_global_alloc_bit = false;
+    #ifdef MMTK_ENABLE_GLOBAL_ALLOC_BIT
+    enable_global_alloc_bit = true;
+    #endif
+    if (enable_global_alloc_bit || selector.tag == TAG_MARK_COMPACT) {
+      // end is free from here. It is recovered from lab.cursor below if it aliases var_size_in_bytes.
+      // end = 1 << ((obj >> 3) & 7)
+      __ srli(t0, obj, 3);
+      __ andi(t0, t0, 7);
+      __ li(end, 1);
+      __ sll(end, end, t0);
+      // t1 = ALLOC_BIT_BASE_ADDRESS + (obj >> 6)
+      __ srli(t0, obj, 6);
+      __ li(t1, ALLOC_BIT_BASE_ADDRESS);
+      __ add(t1, t1, t0);
+      // store-byte (load-byte t1) | end
+      __ lbu(t0, Address(t1));
+      __ orr(t0, t0, end);
+      __ sb(t0, Address(t1));
+      if (var_size_in_bytes == end) {
+        __ ld(end, cursor);
+      }
+    }
+
     // recover var_size_in_bytes if necessary
     if (var_size_in_bytes == end) {
       __ sub(var_size_in_bytes, var_size_in_bytes, obj);
@@ -126,10 +155,6 @@ void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register obj,
 
     // XXX debug use, force double allocation
     // __ j(slow_case);
-
-  #ifdef MMTK_ENABLE_GLOBAL_ALLOC_BIT
-    assert(false, "global alloc bit not supported");
-  #endif
   }
 }
 
@@ -160,11 +185,11 @@ void MMTkBarrierSetAssembler::generate_c1_write_barrier_runtime_stub(StubAssembl
   //                        t2, a0-a7,   t3-t6
   __ push_call_clobbered_registers();
 
-#if MMTK_ENABLE_BARRIER_FASTPATH
-  __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), src, slot, new_val);
-#else
-  __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), src, slot, new_val);
-#endif
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_C1)) {
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), src, slot, new_val);
+  } else {
+    __ call_VM_leaf(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), src, slot, new_val);
+  }
 
   __ pop_call_clobbered_registers();
 
@@ -182,14 +207,32 @@ void MMTkBarrierSetAssembler::generate_c1_write_barrier_stub_call(LIR_Assembler*
   // See also void G1BarrierSetAssembler::gen_post_barrier_stub(LIR_Assembler* ce, G1PostBarrierStub* stub)
   MMTkBarrierSetC1* bs = (MMTkBarrierSetC1*) BarrierSet::barrier_set()->barrier_set_c1();
   __ bind(*stub->entry());
+  assert(stub->new_val->is_register(), "Precondition");
+  Register new_val = stub->new_val->as_pointer_register();
+  // t0 and t1 are scratch registers, never allocated by C1
+  if (MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET)) {
+    // if ((uintptr_t) new_val - heap_start >= heap_extent) skip;
+    __ li(t0, (int64_t) MMTkFastPaths::heap_start());
+    __ sub(t0, new_val, t0);
+    __ li(t1, (int64_t) MMTkFastPaths::heap_extent());
+    __ bgeu(t0, t1, *stub->continuation());
+  } else if (MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)) {
+    // if (new_val == NULL) skip;
+    __ beqz(new_val, *stub->continuation());
+  }
+  if (stub->site != NULL) {
+    __ li(t1, (int64_t) stub->site->count_addr());
+    __ ld(t0, Address(t1));
+    __ addi(t0, t0, 1);
+    __ sd(t0, Address(t1));
+  }
   assert(stub->src->is_register(), "Precondition");
   assert(stub->slot->is_register(), "Precondition");
-  assert(stub->new_val->is_register(), "Precondition");
   // LIR_Assembler::store_parameter(Register r, int offset_from_rsp_in_words)
   // __ sd(r, Address(sp, offset_from_rsp_in_bytes));
   ce->store_parameter(stub->src->as_pointer_register(), 0);
   ce->store_parameter(stub->slot->as_pointer_register(), 1);
-  ce->store_parameter(stub->new_val->as_pointer_register(), 2);
+  ce->store_parameter(new_val, 2);
   __ far_call(RuntimeAddress(bs->_write_barrier_c1_runtime_code_blob->code_begin()));
   __ j(*stub->continuation());
 }
@@ -42,42 +42,54 @@ void MMTkObjectBarrierSetAssembler::object_reference_write_post(MacroAssembler*
   if (dst.base()->is_valid()) {
     __ push_reg(dst.base());
   }
-  
-#if MMTK_ENABLE_BARRIER_FASTPATH
   Label done;
-  assert_different_registers(obj, tmp1, tmp2);
-  assert_different_registers(val, tmp1, tmp2);
-  assert(tmp1->is_valid(), "need temp reg");
-  assert(tmp2->is_valid(), "need temp reg");
-  // tmp1 = load-byte (SIDE_METADATA_BASE_ADDRESS + (obj >> 6));
-  __ mv(tmp1, obj);
-  __ srli(tmp1, tmp1, 6); // tmp1 = obj >> 6;
-  __ li(tmp2, SIDE_METADATA_BASE_ADDRESS);
-  __ add(tmp1, tmp1, tmp2); // tmp1 = SIDE_METADATA_BASE_ADDRESS + (obj >> 6);
-  __ lbu(tmp1, Address(tmp1, 0));
-  // tmp2 = (obj >> 3) & 7
-  __ mv(tmp2, obj);
-  __ srli(tmp2, tmp2, 3);
-  __ andi(tmp2, tmp2, 7);
-  // tmp1 = tmp1 >> tmp2
-  __ sraw(tmp1, tmp1, tmp2);
-  // if ((tmp1 & 1) == 1) fall through to slowpath;
-  // equivalently ((tmp1 & 1) == 0) go to done
-  __ andi(tmp1, tmp1, 1);
-  __ beqz(tmp1, done);
-  // setup calling convention
-  __ mv(c_rarg0, obj);
-  __ la(c_rarg1, dst);
-  __ mv(c_rarg2, val == noreg ? zr : val);
-  __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
+
+  if (val != noreg && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET)) {
+    assert_different_registers(val, tmp1, tmp2);
+    // if ((uintptr_t) val - heap_start >= heap_extent) goto done;
+    __ li(tmp2, MMTkFastPaths::heap_start());
+    __ sub(tmp1, val, tmp2);
+    __ li(tmp2, MMTkFastPaths::heap_extent());
+    __ bgeu(tmp1, tmp2, done);
+  } else if (val != noreg && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)) {
+    // if (val == NULL) goto done;
+    __ beqz(val, done);
+  }
+
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_INTERPRETER)) {
+    assert_different_registers(obj, tmp1, tmp2);
+    assert_different_registers(val, tmp1, tmp2);
+    assert(tmp1->is_valid(), "need temp reg");
+    assert(tmp2->is_valid(), "need temp reg");
+    // tmp1 = load-byte (SIDE_METADATA_BASE_ADDRESS + (obj >> 6));
+    __ mv(tmp1, obj);
+    __ srli(tmp1, tmp1, 6); // tmp1 = obj >> 6;
+    __ li(tmp2, SIDE_METADATA_BASE_ADDRESS);
+    __ add(tmp1, tmp1, tmp2); // tmp1 = SIDE_METADATA_BASE_ADDRESS + (obj >> 6);
+    __ lbu(tmp1, Address(tmp1, 0));
+    // tmp2 = (obj >> 3) & 7
+    __ mv(tmp2, obj);
+    __ srli(tmp2, tmp2, 3);
+    __ andi(tmp2, tmp2, 7);
+    // tmp1 = tmp1 >> tmp2
+    __ sraw(tmp1, tmp1, tmp2);
+    // if ((tmp1 & 1) == 1) fall through to slowpath;
+    // equivalently ((tmp1 & 1) == 0) go to done
+    __ andi(tmp1, tmp1, 1);
+    __ beqz(tmp1, done);
+    // setup calling convention
+    __ mv(c_rarg0, obj);
+    __ la(c_rarg1, dst);
+    __ mv(c_rarg2, val == noreg ? zr : val);
+    __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
+  } else {
+    __ mv(c_rarg0, obj);
+    __ la(c_rarg1, dst);
+    __ mv(c_rarg2, val == noreg ? zr : val);
+    __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
+  }
 
   __ bind(done);
-#else
-  __ mv(c_rarg0, obj);
-  __ la(c_rarg1, dst);
-  __ mv(c_rarg2, val == noreg ? zr : val);
-  __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
-#endif
   if (dst.base()->is_valid()) {
     __ pop_reg(dst.base());
   }
@@ -28,6 +28,7 @@
 #include "mmtkBarrierSetAssembler_x86.hpp"
 #include "mmtkBarrierSetC1.hpp"
 #include "mmtkMutator.hpp"
+#include "mmtkSlowPathCounters.hpp"
 #include "runtime/sharedRuntime.hpp"
 #include "utilities/macros.hpp"
 #include "c1/c1_LIRAssembler.hpp"
@@ -36,10 +37,15 @@
 #define __ masm->
 
 void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register thread, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register t1, Label& slow_case) {
+  // The caller did not say which tier it generates code for. It may be the interpreter or C1.
+  eden_allocate(masm, MMTK_FASTPATH_INTERPRETER | MMTK_FASTPATH_C1, thread, obj, var_size_in_bytes, con_size_in_bytes, t1, slow_case);
+}
+
+void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, uint8_t tiers, Register thread, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register t1, Label& slow_case) {
   assert(obj == rax, "obj must be in rax, for cmpxchg");
   assert_different_registers(obj, var_size_in_bytes, t1);
 
-  if (!MMTK_ENABLE_ALLOCATION_FASTPATH) {
+  if (!MMTkFastPaths::allocation_in_all(tiers)) {
     __ jmp(slow_case);
   } else {
     // MMTk size check. If the alloc size is larger than the allowed max size for non los,
@@ -164,11 +170,11 @@ void MMTkBarrierSetAssembler::generate_c1_write_barrier_runtime_stub(StubAssembl
 
   __ save_live_registers_no_oop_map(true);
 
-#if MMTK_ENABLE_BARRIER_FASTPATH
-  __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
-#else
-  __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
-#endif
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_C1)) {
+    __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
+  } else {
+    __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
+  }
 
   __ restore_live_registers(true);
 
@@ -188,9 +194,24 @@ void MMTkBarrierSetAssembler::generate_c1_write_barrier_runtime_stub(StubAssembl
 void MMTkBarrierSetAssembler::generate_c1_write_barrier_stub_call(LIR_Assembler* ce, MMTkC1BarrierStub* stub) {
   MMTkBarrierSetC1* bs = (MMTkBarrierSetC1*) BarrierSet::barrier_set()->barrier_set_c1();
   __ bind(*stub->entry());
+  Register new_val = stub->new_val->as_pointer_register();
+  if (MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET)) {
+    // if (new_val < heap_start || new_val >= heap_start + heap_extent) skip;
+    __ mov64(rscratch1, MMTkFastPaths::heap_start());
+    __ cmpptr(new_val, rscratch1);
+    __ jcc(Assembler::below, *stub->continuation());
+    __ mov64(rscratch1, MMTkFastPaths::heap_start() + MMTkFastPaths::heap_extent());
+    __ cmpptr(new_val, rscratch1);
+    __ jcc(Assembler::aboveEqual, *stub->continuation());
+  } else if (MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)) {
+    // if (new_val == NULL) skip;
+    __ testptr(new_val, new_val);
+    __ jcc(Assembler::zero, *stub->continuation());
+  }
+  if (stub->site != NULL) __ incrementq(ExternalAddress(stub->site->count_addr()));
   ce->store_parameter(stub->src->as_pointer_register(), 0);
   ce->store_parameter(stub->slot->as_pointer_register(), 1);
-  ce->store_parameter(stub->new_val->as_pointer_register(), 2);
+  ce->store_parameter(new_val, 2);
   __ call(RuntimeAddress(bs->_write_barrier_c1_runtime_code_blob->code_begin()));
   __ jmp(*stub->continuation());
 }
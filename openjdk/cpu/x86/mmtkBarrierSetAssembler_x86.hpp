@@ -31,6 +31,9 @@ protected:
 
 public:
   virtual void eden_allocate(MacroAssembler* masm, Register thread, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register t1, Label& slow_case) override;
+  /// Allocation fast-path for code run by `tiers` (MMTK_FASTPATH_* bits), which jumps to `slow_case`
+  /// unless all of them have the fast-path. The interpreter and C1 pass their own tier.
+  void eden_allocate(MacroAssembler* masm, uint8_t tiers, Register thread, Register obj, Register var_size_in_bytes, int con_size_in_bytes, Register t1, Label& slow_case);
   virtual void store_at(MacroAssembler* masm, DecoratorSet decorators, BasicType type, Address dst, Register val, Register tmp1, Register tmp2, Register tmp3) {
     if (type == T_OBJECT || type == T_ARRAY) object_reference_write_pre(masm, decorators, dst, val, tmp1, tmp2);
     BarrierSetAssembler::store_at(masm, decorators, type, dst, val, tmp1, tmp2, tmp3);
@@ -7,53 +7,60 @@
 void MMTkObjectBarrierSetAssembler::object_reference_write_post(MacroAssembler* masm, DecoratorSet decorators, Address dst, Register val, Register tmp1, Register tmp2) const {
   if (can_remove_barrier(decorators, val, /* skip_const_null */ true)) return;
   Register obj = dst.base();
-#if MMTK_ENABLE_BARRIER_FASTPATH
+  Register tmp3 = rscratch1;
   Label done;
 
-  Register tmp3 = rscratch1;
-  Register tmp4 = rscratch2;
-  assert_different_registers(obj, tmp2, tmp3);
-  assert_different_registers(tmp4, rcx);
+  if (val != noreg && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET)) {
+    assert_different_registers(val, tmp2, tmp3);
+    // if ((uintptr_t) val - heap_start >= heap_extent) goto done;
+    __ movptr(tmp2, val);
+    __ movptr(tmp3, (intptr_t) MMTkFastPaths::heap_start());
+    __ subptr(tmp2, tmp3);
+    __ movptr(tmp3, (intptr_t) MMTkFastPaths::heap_extent());
+    __ cmpptr(tmp2, tmp3);
+    __ jcc(Assembler::aboveEqual, done);
+  } else if (val != noreg && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)) {
+    // if (val == NULL) goto done;
+    __ testptr(val, val);
+    __ jcc(Assembler::zero, done);
+  }
 
-  // tmp2 = load-byte (SIDE_METADATA_BASE_ADDRESS + (obj >> 6));
-  __ movptr(tmp3, obj);
-  __ shrptr(tmp3, 6);
-  __ movptr(tmp2, SIDE_METADATA_BASE_ADDRESS);
-  __ movb(tmp2, Address(tmp2, tmp3));
-  // tmp3 = (obj >> 3) & 7
-  __ movptr(tmp3, obj);
-  __ shrptr(tmp3, 3);
-  __ andptr(tmp3, 7);
-  // tmp2 = tmp2 >> tmp3
-  __ movptr(tmp4, rcx);
-  __ movl(rcx, tmp3);
-  __ shrptr(tmp2);
-  __ movptr(rcx, tmp4);
-  // if ((tmp2 & 1) == 1) goto slowpath;
-  __ andptr(tmp2, 1);
-  __ cmpptr(tmp2, 1);
-  __ jcc(Assembler::notEqual, done);
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_INTERPRETER)) {
+    assert_different_registers(obj, tmp2, tmp3);
 
-  __ movptr(c_rarg0, obj);
-  __ lea(c_rarg1, dst);
-  if (val == noreg) {
-    __ movptr(c_rarg2, NULL_WORD);
+    // The log bit of obj is bit ((obj >> 3) & 63) of the 64-bit metadata word at
+    // SIDE_METADATA_BASE_ADDRESS + (obj >> 9) * 8 (side metadata is little-endian).
+    // tmp2 = load-word (SIDE_METADATA_BASE_ADDRESS + (obj >> 9) * 8)
+    __ movptr(tmp3, obj);
+    __ shrptr(tmp3, 9);
+    __ movptr(tmp2, SIDE_METADATA_BASE_ADDRESS);
+    __ movq(tmp2, Address(tmp2, tmp3, Address::times_8));
+    // if (!bt(tmp2, obj >> 3)) goto done; bt only uses the low 6 bits of the bit offset.
+    __ movptr(tmp3, obj);
+    __ shrptr(tmp3, 3);
+    __ btq(tmp2, tmp3);
+    __ jcc(Assembler::carryClear, done);
+
+    __ movptr(c_rarg0, obj);
+    __ lea(c_rarg1, dst);
+    if (val == noreg) {
+      __ movptr(c_rarg2, NULL_WORD);
+    } else {
+      __ movptr(c_rarg2, val);
+    }
+    __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
   } else {
-    __ movptr(c_rarg2, val);
+    __ movptr(c_rarg0, obj);
+    __ lea(c_rarg1, dst);
+    if (val == noreg) {
+      __ movptr(c_rarg2, NULL_WORD);
+    } else {
+      __ movptr(c_rarg2, val);
+    }
+    __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
   }
-  __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), 3);
 
   __ bind(done);
-#else
-  __ movptr(c_rarg0, obj);
-  __ lea(c_rarg1, dst);
-  if (val == noreg) {
-    __ movptr(c_rarg2, NULL_WORD);
-  } else {
-    __ movptr(c_rarg2, val);
-  }
-  __ call_VM_leaf_base(FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), 3);
-#endif
 }
 
 void MMTkObjectBarrierSetAssembler::arraycopy_epilogue(MacroAssembler* masm, DecoratorSet decorators, BasicType type, Register src, Register dst, Register count) {
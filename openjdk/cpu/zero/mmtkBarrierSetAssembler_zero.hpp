@@ -1,5 +1,7 @@
 #ifndef MMTK_OPENJDK_MMTK_BARRIER_SET_ASSEMBLER_ZERO_HPP
 #define MMTK_OPENJDK_MMTK_BARRIER_SET_ASSEMBLER_ZERO_HPP
 
+// Zero generates no code. Its allocation fast-path is MMTkMutatorContext::alloc_fast,
+// and its barriers are the C++ runtime barriers reached through the Access API.
 class MMTkBarrierSetAssembler;
 #endif // MMTK_OPENJDK_MMTK_BARRIER_SET_ASSEMBLER_ZERO_HPP
@@ -1,9 +1,15 @@
 #include "precompiled.hpp"
 #include "mmtkObjectBarrier.hpp"
+#include "../mmtkMutator.hpp"
+#include "../mmtkSlowPathCounters.hpp"
 #include "runtime/interfaceSupport.inline.hpp"
 
 void MMTkObjectBarrierSetRuntime::object_reference_write_post(oop src, oop* slot, oop target) const {
-#if MMTK_ENABLE_BARRIER_FASTPATH
+  if (MMTkFastPaths::is_filtered((void*) target)) return;
+  log_object(src, slot, target);
+}
+
+void MMTkObjectBarrierSetRuntime::log_object(oop src, oop* slot, oop target) const {
   intptr_t addr = (intptr_t) (void*) src;
   uint8_t* meta_addr = (uint8_t*) (SIDE_METADATA_BASE_ADDRESS + (addr >> 6));
   intptr_t shift = (addr >> 3) & 0b111;
@@ -12,9 +18,49 @@ void MMTkObjectBarrierSetRuntime::object_reference_write_post(oop src, oop* slot
     // MMTkObjectBarrierSetRuntime::object_reference_write_pre_slow()((void*) src);
     object_reference_write_slow_call((void*) src, (void*) slot, (void*) target);
   }
-#else
-  object_reference_write_post_call((void*) src, (void*) slot, (void*) target);
+}
+
+void MMTkObjectBarrierSetRuntime::object_reference_clone_post(oop src, oop dst) const {
+  // Primitive arrays hold no references.
+  if (dst->is_typeArray()) return;
+  // Log the whole destination object once, instead of once per copied field.
+  log_object(dst, NULL, NULL);
+}
+
+/// Find the object that contains `slot` by searching backwards for its alloc bit.
+/// Returns NULL if alloc bits are not maintained, or if no object is found within
+/// the chunk of `slot` and the max non-LOS object size.
+static oop find_enclosing_object(oop* slot) {
+  bool enable_global_alloc_bit = false;
+#ifdef MMTK_ENABLE_GLOBAL_ALLOC_BIT
+  enable_global_alloc_bit = true;
 #endif
+  if (!enable_global_alloc_bit && MMTkMutatorContext::default_allocator_selector.tag != TAG_MARK_COMPACT) return NULL;
+  uintptr_t addr = align_down((uintptr_t) slot, MinObjAlignmentInBytes);
+  // Side metadata is only guaranteed to be mapped for the chunk of `slot`.
+  uintptr_t chunk_start = addr & ~((uintptr_t) CHUNK_MASK);
+  uintptr_t max_distance = MMTkMutatorContext::max_non_los_default_alloc_bytes;
+  uintptr_t limit = addr - chunk_start > max_distance ? addr - max_distance : chunk_start;
+  for (uintptr_t obj = addr; obj >= limit; obj -= MinObjAlignmentInBytes) {
+    uint8_t byte_val = *(uint8_t*) (ALLOC_BIT_BASE_ADDRESS + (obj >> 6));
+    if (((byte_val >> ((obj >> 3) & 0b111)) & 1) == 1) {
+      oop o = cast_to_oop(obj);
+      return (uintptr_t) slot < obj + o->size() * HeapWordSize ? o : NULL;
+    }
+    if (obj == limit) break;
+  }
+  return NULL;
+}
+
+void MMTkObjectBarrierSetRuntime::object_reference_slot_write_post(oop* slot, oop target) const {
+  if (MMTkFastPaths::is_filtered((void*) target)) return;
+  // Prefer the object barrier, so that the log bit stops repeated slow-path calls.
+  oop src = find_enclosing_object(slot);
+  if (src != NULL) {
+    log_object(src, slot, target);
+  } else {
+    object_reference_slot_write_post_call((void*) slot, (void*) target);
+  }
 }
 
 #ifdef COMPILER1
@@ -28,6 +74,8 @@ void MMTkObjectBarrierSetC1::object_reference_write_post(LIRAccess& access, LIR_
   LIRGenerator* gen = access.gen();
   DecoratorSet decorators = access.decorators();
   if ((decorators & IN_HEAP) == 0) return;
+  // A constant null store is filtered statically.
+  if (new_val->is_constant() && new_val->type() == T_OBJECT && new_val->as_jobject() == NULL && MMTkFastPaths::is_filtered(NULL)) return;
   if (!src->is_register()) {
     LIR_Opr reg = gen->new_pointer_register();
     if (src->is_constant()) {
@@ -58,34 +106,38 @@ void MMTkObjectBarrierSetC1::object_reference_write_post(LIRAccess& access, LIR_
     new_val = new_val_reg;
   }
   assert(new_val->is_register(), "must be a register at this point");
-  CodeStub* slow = new MMTkC1BarrierStub(src, slot, new_val);
-
-#if MMTK_ENABLE_BARRIER_FASTPATH
-  LIR_Opr addr = src;
-  // uint8_t* meta_addr = (uint8_t*) (SIDE_METADATA_BASE_ADDRESS + (addr >> 6));
-  LIR_Opr offset = gen->new_pointer_register();
-  __ move(addr, offset);
-  __ unsigned_shift_right(offset, 6, offset);
-  LIR_Opr base = gen->new_pointer_register();
-  __ move(LIR_OprFact::longConst(SIDE_METADATA_BASE_ADDRESS), base);
-  LIR_Address* meta_addr = new LIR_Address(base, offset, T_BYTE);
-  // uint8_t byte_val = *meta_addr;
-  LIR_Opr byte_val = gen->new_register(T_INT);
-  __ move(meta_addr, byte_val);
-  // intptr_t shift = (addr >> 3) & 0b111;
-  LIR_Opr shift = gen->new_register(T_INT);
-  __ move(addr, shift);
-  __ unsigned_shift_right(shift, 3, shift);
-  __ logical_and(shift, LIR_OprFact::intConst(0b111), shift);
-  // if (((byte_val >> shift) & 1) == 1) slow;
-  LIR_Opr result = byte_val;
-  __ unsigned_shift_right(result, shift, result, LIR_OprFact::illegalOpr);
-  __ logical_and(result, LIR_OprFact::intConst(1), result);
-  __ cmp(lir_cond_equal, result, LIR_OprFact::intConst(1));
-  __ branch(lir_cond_equal, slow);
-#else
-  __ jump(slow);
-#endif
+  CodeEmitInfo* info = access.access_emit_info();
+  MMTkSlowPathSite* site = MMTkSlowPathCounters::new_site(MMTkSlowPathCounters::BARRIER, "c1", gen->method(), info != NULL ? info->stack()->bci() : -1);
+  // The stub applies the barrier filters. The inline fast-path only branches to the stub,
+  // as LinearScan expects no control flow within a block.
+  CodeStub* slow = new MMTkC1BarrierStub(src, slot, new_val, site);
+
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_C1)) {
+    LIR_Opr addr = src;
+    // The log bit is bit ((addr >> 3) & 63) of the 64-bit metadata word at SIDE_METADATA_BASE_ADDRESS + (addr >> 9) * 8.
+    // uint64_t* meta_addr = (uint64_t*) (SIDE_METADATA_BASE_ADDRESS + (addr >> 9) * 8);
+    LIR_Opr offset = gen->new_pointer_register();
+    __ move(addr, offset);
+    __ unsigned_shift_right(offset, 9, offset);
+    LIR_Opr base = gen->new_pointer_register();
+    __ move(LIR_OprFact::longConst(SIDE_METADATA_BASE_ADDRESS), base);
+    LIR_Address* meta_addr = new LIR_Address(base, offset, LIR_Address::times_8, 0, T_LONG);
+    // uint64_t word_val = *meta_addr;
+    LIR_Opr word_val = gen->new_register(T_LONG);
+    __ move(meta_addr, word_val);
+    // intptr_t shift = addr >> 3; the long shift below only uses its low 6 bits.
+    LIR_Opr shift = gen->new_register(T_INT);
+    __ move(addr, shift);
+    __ unsigned_shift_right(shift, 3, shift);
+    // if (((word_val >> shift) & 1) == 1) slow;
+    LIR_Opr result = word_val;
+    __ unsigned_shift_right(result, shift, result, LIR_OprFact::illegalOpr);
+    __ logical_and(result, LIR_OprFact::longConst(1), result);
+    __ cmp(lir_cond_equal, result, LIR_OprFact::longConst(1));
+    __ branch(lir_cond_equal, slow);
+  } else {
+    __ jump(slow);
+  }
 
   __ branch_destination(slow->continuation());
 }
@@ -96,36 +148,67 @@ void MMTkObjectBarrierSetC1::object_reference_write_post(LIRAccess& access, LIR_
 #ifdef COMPILER2
 #define __ ideal.
 
-void MMTkObjectBarrierSetC2::object_reference_write_post(GraphKit* kit, Node* src, Node* slot, Node* val) const {
-  if (can_remove_barrier(kit, &kit->gvn(), src, slot, val, /* skip_const_null */ true)) return;
-
+void MMTkObjectBarrierSetC2::log_object(GraphKit* kit, Node* src, Node* val) const {
+  MMTkSlowPathSite* site = MMTkSlowPathCounters::new_site(MMTkSlowPathCounters::BARRIER, "c2", kit->method(), kit->bci());
   MMTkIdealKit ideal(kit, true);
 
-#if MMTK_ENABLE_BARRIER_FASTPATH
-  Node* no_base = __ top();
-  float unlikely  = PROB_UNLIKELY(0.999);
-
-  Node* zero  = __ ConI(0);
-  Node* addr = __ CastPX(__ ctrl(), src);
-  Node* meta_addr = __ AddP(no_base, __ ConP(SIDE_METADATA_BASE_ADDRESS), __ URShiftX(addr, __ ConI(6)));
-  Node* byte = __ load(__ ctrl(), meta_addr, TypeInt::INT, T_BYTE, Compile::AliasIdxRaw);
-  Node* shift = __ URShiftX(addr, __ ConI(3));
-  shift = __ AndI(__ ConvL2I(shift), __ ConI(7));
-  Node* result = __ AndI(__ URShiftI(byte, shift), __ ConI(1));
-
-  // XXX zixianc
-  // Workaround C2 bug in compare-and-swap codegen on RISC-V
-  __ if_then(result, BoolTest::ne, zero, unlikely); {
+  bool filter_target = val != NULL && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_TARGET);
+  bool filter_null = val != NULL && !filter_target && MMTkFastPaths::barrier_filter(MMTK_BARRIER_FILTER_NULL)
+    && kit->gvn().type(val)->make_ptr()->ptr() != TypePtr::NotNull;
+  if (filter_target) {
+    // if ((uintptr_t) val - heap_start < heap_extent). CmpP is an unsigned compare.
+    Node* offset = __ CastXP(__ SubX(__ CastPX(__ ctrl(), val), __ ConX(MMTkFastPaths::heap_start())));
+    __ if_then(offset, BoolTest::lt, __ ConP(MMTkFastPaths::heap_extent()), PROB_LIKELY(0.999));
+  } else if (filter_null) {
+    __ if_then(val, BoolTest::ne, kit->null(), PROB_LIKELY(0.999));
+  }
+
+  if (MMTkFastPaths::barrier(MMTK_FASTPATH_C2)) {
+    Node* no_base = __ top();
+    float unlikely  = PROB_UNLIKELY(0.999);
+
+    Node* zero  = __ ConL(0);
+    Node* addr = __ CastPX(__ ctrl(), src);
+    // The log bit is bit ((addr >> 3) & 63) of the 64-bit metadata word at SIDE_METADATA_BASE_ADDRESS + (addr >> 9) * 8.
+    // The scaled index folds into the addressing mode, and URShiftL masks the shift count.
+    Node* meta_addr = __ AddP(no_base, __ ConP(SIDE_METADATA_BASE_ADDRESS), __ LShiftX(__ URShiftX(addr, __ ConI(9)), __ ConI(3)));
+    Node* word = __ load(__ ctrl(), meta_addr, TypeLong::LONG, T_LONG, Compile::AliasIdxRaw);
+    Node* shift = __ ConvL2I(__ URShiftX(addr, __ ConI(3)));
+    Node* result = __ AndL(__ URShiftL(word, shift), __ ConL(1));
+
+    // XXX zixianc
+    // Workaround C2 bug in compare-and-swap codegen on RISC-V
+    __ if_then(result, BoolTest::ne, zero, unlikely); {
+      if (site != NULL) __ increment(site->count_addr());
+      const TypeFunc* tf = __ func_type(src->bottom_type());
+      Node* x = __ make_leaf_call(tf, FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), "mmtk_barrier_call", src);
+    } __ end_if();
+  } else {
+    if (site != NULL) __ increment(site->count_addr());
     const TypeFunc* tf = __ func_type(src->bottom_type());
-    Node* x = __ make_leaf_call(tf, FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_slow_call), "mmtk_barrier_call", src);
-  } __ end_if();
-#else
-  const TypeFunc* tf = __ func_type(src->bottom_type());
-  Node* x = __ make_leaf_call(tf, FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), "mmtk_barrier_call", src);
-#endif
+    Node* x = __ make_leaf_call(tf, FN_ADDR(MMTkBarrierSetRuntime::object_reference_write_post_call), "mmtk_barrier_call", src);
+  }
+
+  if (filter_target || filter_null) __ end_if();
 
   kit->final_sync(ideal); // Final sync IdealKit and GraphKit.
 }
 
+void MMTkObjectBarrierSetC2::object_reference_write_post(GraphKit* kit, Node* src, Node* slot, Node* val) const {
+  if (can_remove_barrier(kit, &kit->gvn(), src, slot, val, /* skip_const_null */ true)) return;
+  log_object(kit, src, val);
+}
+
+void MMTkObjectBarrierSetC2::object_reference_clone_post(GraphKit* kit, Node* src, Node* dst, bool is_array) const {
+  // Primitive arrays hold no references.
+  if (is_array) {
+    const TypeAryPtr* ary_type = kit->gvn().type(src)->isa_aryptr();
+    if (ary_type != NULL && !is_reference_type(ary_type->elem()->array_element_basic_type())) return;
+  }
+  // The clone may not be in the nursery (e.g. a large array in the LOS),
+  // so `dst` is always checked. A single check covers all the copied fields.
+  log_object(kit, dst);
+}
+
 #undef __
 #endif
\ No newline at end of file
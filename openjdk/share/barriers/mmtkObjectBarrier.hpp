@@ -25,12 +25,16 @@
 const intptr_t SIDE_METADATA_BASE_ADDRESS = (intptr_t) GLOBAL_SIDE_METADATA_VM_BASE_ADDRESS;
 
 class MMTkObjectBarrierSetRuntime: public MMTkBarrierSetRuntime {
+  /// Check the log bit of `src` and call the slow-path if it is still unlogged.
+  void log_object(oop src, oop* slot, oop target) const;
 public:
   // Interfaces called by `MMTkBarrierSet::AccessBarrier`
   virtual void object_reference_write_post(oop src, oop* slot, oop target) const override;
   virtual void object_reference_array_copy_post(oop* src, oop* dst, size_t count) const override {
     object_reference_array_copy_post_call((void*) src, (void*) dst, count);
   }
+  virtual void object_reference_clone_post(oop src, oop dst) const override;
+  virtual void object_reference_slot_write_post(oop* slot, oop target) const override;
 };
 
 #ifdef COMPILER1
@@ -48,8 +52,19 @@ class MMTkObjectBarrierSetC1;
 
 #ifdef COMPILER2
 class MMTkObjectBarrierSetC2: public MMTkBarrierSetC2 {
+  /// Check the log bit of `src` and call the slow-path if it is still unlogged.
+  /// If the stored value `val` is given, the configured barrier filters are applied to it first.
+  void log_object(GraphKit* kit, Node* src, Node* val = NULL) const;
 protected:
   virtual void object_reference_write_post(GraphKit* kit, Node* src, Node* slot, Node* val) const override;
+  virtual void object_reference_clone_post(GraphKit* kit, Node* src, Node* dst, bool is_array) const override;
+public:
+  virtual bool array_copy_requires_gc_barriers(bool tightly_coupled_alloc, BasicType type, bool is_clone, bool is_clone_instance, ArrayCopyPhase phase) const override {
+    // A clone logs the whole destination once (see object_reference_clone_post).
+    // A tightly-coupled destination (e.g. of Arrays.copyOf) still needs the barriers: a large array is allocated
+    // in the LOS, which is mature and unlogged.
+    return is_reference_type(type) && !is_clone;
+  }
 };
 #else
 class MMTkObjectBarrierSetC2;
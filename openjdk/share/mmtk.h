@@ -25,6 +25,25 @@ extern const size_t MMTK_MARK_COMPACT_HEADER_RESERVED_IN_BYTES;
 
 extern const char* get_mmtk_version();
 
+// Tiers that may generate inline fast-paths. These need to match `FASTPATH_*` in mmtk/src/api.rs
+#define MMTK_FASTPATH_INTERPRETER (1 << 0)
+#define MMTK_FASTPATH_C1          (1 << 1)
+#define MMTK_FASTPATH_C2          (1 << 2)
+
+extern uint8_t mmtk_allocation_fast_paths();
+extern uint8_t mmtk_barrier_fast_paths();
+extern bool mmtk_count_slow_paths();
+
+// Stored values that the barrier may skip. These need to match `BARRIER_FILTER_*` in mmtk/src/api.rs
+#define MMTK_BARRIER_FILTER_NULL   (1 << 0)
+#define MMTK_BARRIER_FILTER_TARGET (1 << 1)
+
+extern uint8_t mmtk_barrier_filters();
+
+extern bool mmtk_partial_stack_scanning();
+extern bool mmtk_nmethod_entry_barriers();
+extern size_t mmtk_stw_spin_iterations();
+
 /**
  * Allocation
  */
@@ -54,6 +73,9 @@ extern void mmtk_object_reference_write_post(MMTk_Mutator mutator, void* src, vo
 /// Generic slow-path
 extern void mmtk_object_reference_write_slow(MMTk_Mutator mutator, void* src, void* slot, void* target);
 
+/// Slot-based post-barrier, for a store whose source object is unknown
+extern void mmtk_object_reference_slot_write_post(MMTk_Mutator mutator, void* slot, void* target);
+
 /// Full array-copy pre-barrier
 extern void mmtk_array_copy_pre(MMTk_Mutator mutator, void* src, void* dst, size_t count);
 
@@ -63,6 +85,8 @@ extern void mmtk_array_copy_post(MMTk_Mutator mutator, void* src, void* dst, siz
 extern void release_buffer(void** buffer, size_t len, size_t cap);
 
 extern bool is_in_mmtk_spaces(void* ref);
+extern bool mmtk_is_live(void* object);
+extern void* mmtk_get_forwarded_object(void* object);
 extern bool is_mapped_address(void* addr);
 extern void modify_check(void* ref);
 
@@ -117,15 +141,6 @@ typedef struct {
     size_t cap;
 } NewBuffer;
 
-struct MutatorClosure {
-    void (*func)(MMTk_Mutator mutator, void* data);
-    void* data;
-
-    void invoke(MMTk_Mutator mutator) {
-        func(mutator, data);
-    }
-};
-
 struct EdgesClosure {
     NewBuffer (*func)(void** buf, size_t size, size_t capa, void* data);
     void* data;
@@ -139,13 +154,12 @@ struct EdgesClosure {
  * OpenJDK-specific
  */
 typedef struct {
-    void (*stop_all_mutators) (void *tls, bool scan_mutators_in_safepoint, MutatorClosure closure);
+    void (*stop_all_mutators) (void *tls);
     void (*resume_mutators) (void *tls);
     void (*spawn_gc_thread) (void *tls, int kind, void *ctx);
     void (*block_for_gc) ();
     void (*out_of_memory) (void *tls, MMTkAllocationError err_kind);
-    void* (*get_next_mutator) ();
-    void (*reset_mutator_iterator) ();
+    size_t (*get_mutators) (void** mutators, size_t capacity);
     void (*scan_object) (void* trace, void* object, void* tls);
     void (*dump_object) (void* object);
     size_t (*get_object_size) (void* object);
@@ -159,12 +173,20 @@ typedef struct {
     int (*referent_offset) ();
     int (*discovered_offset) ();
     char* (*dump_object_string) (void* object);
-    void (*scan_all_thread_roots)(EdgesClosure closure);
-    void (*scan_thread_roots)(EdgesClosure closure, void* tls);
+    void* (*scan_all_thread_roots)(EdgesClosure closure);
+    void* (*scan_thread_roots)(EdgesClosure closure, void* tls, bool partial);
+    void (*update_derived_pointers)(void* derived_pointers);
     void (*scan_code_cache_roots) (EdgesClosure closure);
-    void (*scan_class_loader_data_graph_roots) (EdgesClosure closure);
+    void (*fix_nmethod_relocations) (void* nm, bool partial_stack_scanning);
+    void (*scan_class_loader_data_graph_roots) (EdgesClosure closure, bool class_unloading);
+    void (*scan_class_loader_data) (void* cld, EdgesClosure closure);
+    void* (*class_loader_data_of) (void* object);
+    bool (*class_unloading_enabled) ();
+    void (*unload_classes) ();
+    void (*clear_claimed_cld_marks) ();
     void (*scan_oop_storage_set_roots) (EdgesClosure closure);
     void (*scan_weak_processor_roots) (EdgesClosure closure);
+    void (*process_weak_processor_roots) (size_t worker_id);
     void (*scan_vm_thread_roots) (EdgesClosure closure);
     size_t (*number_of_mutators)();
     void (*schedule_finalizer)();
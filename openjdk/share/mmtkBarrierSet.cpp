@@ -26,9 +26,14 @@
 #include "barriers/mmtkNoBarrier.hpp"
 #include "barriers/mmtkObjectBarrier.hpp"
 #include "mmtkBarrierSet.hpp"
+#include "mmtkBarrierSetNMethod.hpp"
+#include "mmtkSlowPathCounters.hpp"
+#include "mmtkStackWatermark.hpp"
 #include "utilities/macros.hpp"
 #include CPU_HEADER(mmtkBarrierSetAssembler)
 #include "runtime/interfaceSupport.inline.hpp"
+#include "runtime/stackWatermarkSet.hpp"
+#include "runtime/thread.hpp"
 #ifdef COMPILER1
 #include "mmtkBarrierSetC1.hpp"
 #endif
@@ -89,7 +94,7 @@ MMTkBarrierSet::MMTkBarrierSet(MemRegion whole_heap):
   BarrierSet((BarrierSetAssembler*) get_selected_barrier()->create_assembler(),
              (BarrierSetC1*) get_selected_barrier()->create_c1(),
              (BarrierSetC2*) get_selected_barrier()->create_c2(),
-             NULL,
+             MMTkBarrierSetNMethod::enabled() ? new MMTkBarrierSetNMethod() : NULL,
              BarrierSet::FakeRtti(BarrierSet::ThirdPartyHeapBarrierSet)),
   _whole_heap(whole_heap),
   _runtime(get_selected_barrier()->create_runtime()) {}
@@ -112,6 +117,10 @@ void MMTkBarrierSet::on_thread_destroy(Thread* thread) {
 
 void MMTkBarrierSet::on_thread_attach(Thread* thread) {
   thread->third_party_heap_mutator.flush();
+  if (MMTkStackWatermark::enabled() && thread->is_Java_thread()) {
+    JavaThread* jt = JavaThread::cast(thread);
+    StackWatermarkSet::add_watermark(jt, new MMTkStackWatermark(jt));
+  }
 }
 
 void MMTkBarrierSet::on_thread_detach(Thread* thread) {
@@ -127,7 +136,29 @@ bool MMTkBarrierSet::is_aligned(HeapWord* addr) {
 
 // Print a description of the memory for the barrier set
 void MMTkBarrierSet::print_on(outputStream* st) const {
+  MMTkFastPaths::print_on(st);
+}
+
+uint8_t MMTkFastPaths::_allocation = 0;
+uint8_t MMTkFastPaths::_barrier = 0;
+uint8_t MMTkFastPaths::_barrier_filters = 0;
+uintptr_t MMTkFastPaths::_heap_start = 0;
+uintptr_t MMTkFastPaths::_heap_extent = 0;
+
+void MMTkFastPaths::initialize() {
+  _allocation = mmtk_allocation_fast_paths();
+  _barrier = mmtk_barrier_fast_paths();
+  _barrier_filters = mmtk_barrier_filters();
+  _heap_start = (uintptr_t) starting_heap_address();
+  _heap_extent = (uintptr_t) last_heap_address() - _heap_start;
+}
 
+void MMTkFastPaths::print_on(outputStream* st) {
+  st->print_cr("MMTk fast-paths: allocation (interpreter: %s, c1: %s, c2: %s), barrier (interpreter: %s, c1: %s, c2: %s)",
+    BOOL_TO_STR(allocation(MMTK_FASTPATH_INTERPRETER)), BOOL_TO_STR(allocation(MMTK_FASTPATH_C1)), BOOL_TO_STR(allocation(MMTK_FASTPATH_C2)),
+    BOOL_TO_STR(barrier(MMTK_FASTPATH_INTERPRETER)), BOOL_TO_STR(barrier(MMTK_FASTPATH_C1)), BOOL_TO_STR(barrier(MMTK_FASTPATH_C2)));
+  st->print_cr("MMTk barrier filters: null: %s, target: %s",
+    BOOL_TO_STR(barrier_filter(MMTK_BARRIER_FILTER_NULL)), BOOL_TO_STR(barrier_filter(MMTK_BARRIER_FILTER_TARGET)));
 }
 
 bool MMTkBarrierSet::is_slow_path_call(address call) {
@@ -139,13 +170,20 @@ void MMTkBarrierSetRuntime::object_reference_write_pre_call(void* src, void* slo
 }
 
 void MMTkBarrierSetRuntime::object_reference_write_post_call(void* src, void* slot, void* target) {
+  if (MMTkSlowPathCounters::enabled()) MMTkSlowPathCounters::count_barrier_slow();
   ::mmtk_object_reference_write_post((MMTk_Mutator) &Thread::current()->third_party_heap_mutator, src, slot, target);
 }
 
 void MMTkBarrierSetRuntime::object_reference_write_slow_call(void* src, void* slot, void* target) {
+  if (MMTkSlowPathCounters::enabled()) MMTkSlowPathCounters::count_barrier_slow();
   ::mmtk_object_reference_write_slow((MMTk_Mutator) &Thread::current()->third_party_heap_mutator, src, slot, target);
 }
 
+void MMTkBarrierSetRuntime::object_reference_slot_write_post_call(void* slot, void* target) {
+  if (MMTkSlowPathCounters::enabled()) MMTkSlowPathCounters::count_barrier_slow();
+  ::mmtk_object_reference_slot_write_post((MMTk_Mutator) &Thread::current()->third_party_heap_mutator, slot, target);
+}
+
 void MMTkBarrierSetRuntime::object_reference_array_copy_pre_call(void* src, void* dst, size_t count) {
   ::mmtk_array_copy_pre((MMTk_Mutator) &Thread::current()->third_party_heap_mutator, src, dst, count);
 }
@@ -37,8 +37,38 @@
 #include "utilities/macros.hpp"
 #include CPU_HEADER(mmtkBarrierSetAssembler)
 
-#define MMTK_ENABLE_ALLOCATION_FASTPATH true
-#define MMTK_ENABLE_BARRIER_FASTPATH true
+/**
+ * The tiers (MMTK_FASTPATH_* bits) that generate the inline allocation and barrier fast-paths.
+ * They are selected by the `openjdk_allocation_fastpath` and `openjdk_barrier_fastpath` entries
+ * of ThirdPartyHeapOptions, and are checked at code-generation time.
+ */
+class MMTkFastPaths: AllStatic {
+  static uint8_t _allocation;
+  static uint8_t _barrier;
+  static uint8_t _barrier_filters;
+  static uintptr_t _heap_start;
+  static uintptr_t _heap_extent;
+public:
+  /// Read the selected fast-paths from MMTk. Must be called after the options are processed.
+  static void initialize();
+  static bool allocation(uint8_t tier) { return (_allocation & tier) != 0; }
+  /// Whether all the tiers in `tiers` generate the allocation fast-path.
+  static bool allocation_in_all(uint8_t tiers) { return (_allocation & tiers) == tiers; }
+  static bool barrier(uint8_t tier) { return (_barrier & tier) != 0; }
+  /// Whether the barrier skips stored values matched by `filter` (MMTK_BARRIER_FILTER_* bits),
+  /// selected by the `openjdk_barrier_filter` entry of ThirdPartyHeapOptions.
+  /// A null value never creates an edge. The target filter skips values outside the MMTk heap,
+  /// which includes null, with a single unsigned compare: `value - heap_start() >= heap_extent()`.
+  static bool barrier_filter(uint8_t filter) { return (_barrier_filters & filter) != 0; }
+  static uintptr_t heap_start() { return _heap_start; }
+  static uintptr_t heap_extent() { return _heap_extent; }
+  /// Whether the barrier can skip a store of `value`.
+  static bool is_filtered(void* value) {
+    if (barrier_filter(MMTK_BARRIER_FILTER_TARGET)) return (uintptr_t) value - _heap_start >= _heap_extent;
+    return barrier_filter(MMTK_BARRIER_FILTER_NULL) && value == NULL;
+  }
+  static void print_on(outputStream* st);
+};
 
 const intptr_t ALLOC_BIT_BASE_ADDRESS = GLOBAL_ALLOC_BIT_ADDRESS;
 
@@ -66,6 +96,8 @@ public:
   static void object_reference_write_post_call(void* src, void* slot, void* target);
   /// Generic slow-path. Called by fast-paths.
   static void object_reference_write_slow_call(void* src, void* slot, void* target);
+  /// Slot-based post-barrier, for a store whose source object is unknown.
+  static void object_reference_slot_write_post_call(void* slot, void* target);
   /// Generic arraycopy post-barrier. Called by fast-paths.
   static void object_reference_array_copy_pre_call(void* src, void* dst, size_t count);
   /// Generic arraycopy pre-barrier. Called by fast-paths.
@@ -75,6 +107,7 @@ public:
     return call == CAST_FROM_FN_PTR(address, object_reference_write_pre_call)
         || call == CAST_FROM_FN_PTR(address, object_reference_write_post_call)
         || call == CAST_FROM_FN_PTR(address, object_reference_write_slow_call)
+        || call == CAST_FROM_FN_PTR(address, object_reference_slot_write_post_call)
         || call == CAST_FROM_FN_PTR(address, object_reference_array_copy_pre_call)
         || call == CAST_FROM_FN_PTR(address, object_reference_array_copy_post_call);
   }
@@ -83,10 +116,16 @@ public:
   virtual void object_reference_write_pre(oop src, oop* slot, oop target) const {};
   /// Full post-barrier
   virtual void object_reference_write_post(oop src, oop* slot, oop target) const {};
+  /// Full pre-barrier for a store without a base object
+  virtual void object_reference_slot_write_pre(oop* slot, oop target) const {};
+  /// Full post-barrier for a store without a base object
+  virtual void object_reference_slot_write_post(oop* slot, oop target) const {};
   /// Full arraycopy pre-barrier
   virtual void object_reference_array_copy_pre(oop* src, oop* dst, size_t count) const {};
   /// Full arraycopy post-barrier
   virtual void object_reference_array_copy_post(oop* src, oop* dst, size_t count) const {};
+  /// Full clone post-barrier. Called once per clone, after all fields are copied to `dst`.
+  virtual void object_reference_clone_post(oop src, oop dst) const {};
 };
 
 class MMTkBarrierC1;
@@ -159,7 +198,6 @@ public:
   // 2) Make sure the barrier set headers are included from barrierSetConfig.inline.hpp
   // 3) Provide specializations for BarrierSet::GetName and BarrierSet::GetType.
 
-  #define UNREACHABLE() guarantee(false, "UNREACHABLE");
   template <DecoratorSet decorators, typename BarrierSetT = MMTkBarrierSet>
   class AccessBarrier: public BarrierSet::AccessBarrier<decorators, BarrierSetT> {
   private:
@@ -167,7 +205,9 @@ public:
   public:
     template <typename T>
     static void oop_store_in_heap(T* addr, oop value) {
-      UNREACHABLE();
+      runtime()->object_reference_slot_write_pre((oop*) addr, value);
+      Raw::oop_store(addr, value);
+      runtime()->object_reference_slot_write_post((oop*) addr, value);
     }
 
     static void oop_store_in_heap_at(oop base, ptrdiff_t offset, oop value) {
@@ -178,8 +218,10 @@ public:
 
     template <typename T>
     static oop oop_atomic_cmpxchg_in_heap(T* addr, oop compare_value, oop new_value) {
-      UNREACHABLE();
-      return NULL;
+      runtime()->object_reference_slot_write_pre((oop*) addr, new_value);
+      oop result = Raw::oop_atomic_cmpxchg(addr, compare_value, new_value);
+      runtime()->object_reference_slot_write_post((oop*) addr, new_value);
+      return result;
     }
 
     static oop oop_atomic_cmpxchg_in_heap_at(oop base, ptrdiff_t offset, oop compare_value, oop new_value) {
@@ -191,8 +233,10 @@ public:
 
     template <typename T>
     static oop oop_atomic_xchg_in_heap(T* addr, oop new_value) {
-      UNREACHABLE();
-      return NULL;
+      runtime()->object_reference_slot_write_pre((oop*) addr, new_value);
+      oop result = Raw::oop_atomic_xchg(addr, new_value);
+      runtime()->object_reference_slot_write_post((oop*) addr, new_value);
+      return result;
     }
 
     static oop oop_atomic_xchg_in_heap_at(oop base, ptrdiff_t offset, oop new_value) {
@@ -217,8 +261,8 @@ public:
     }
 
     static void clone_in_heap(oop src, oop dst, size_t size) {
-      // TODO: We don't need clone barriers at the moment.
       Raw::clone(src, dst, size);
+      runtime()->object_reference_clone_post(src, dst);
     }
   };
 
@@ -5,6 +5,7 @@
 #include "gc/shared/c1/barrierSetC1.hpp"
 
 class MMTkBarrierSetAssembler;
+class MMTkSlowPathSite;
 
 class MMTkBarrierSetC1 : public BarrierSetC1 {
   friend class MMTkBarrierSetAssembler;
@@ -69,8 +70,10 @@ public:
 /// Barrier implementations may inherit from this class, and override `emit_code` to perform a specialized slow-path call.
 struct MMTkC1BarrierStub: CodeStub {
   LIR_Opr src, slot, new_val;
+  /// Counter to increment when the stub is entered. NULL unless slow-path counting is enabled.
+  MMTkSlowPathSite* site;
 
-  MMTkC1BarrierStub(LIR_Opr src, LIR_Opr slot, LIR_Opr new_val): src(src), slot(slot), new_val(new_val) {}
+  MMTkC1BarrierStub(LIR_Opr src, LIR_Opr slot, LIR_Opr new_val, MMTkSlowPathSite* site = NULL): src(src), slot(slot), new_val(new_val), site(site) {}
 
   virtual void emit_code(LIR_Assembler* ce) override;
 
@@ -28,6 +28,7 @@
 #include "mmtkBarrierSet.hpp"
 #include "mmtkBarrierSetC2.hpp"
 #include "mmtkMutator.hpp"
+#include "mmtkSlowPathCounters.hpp"
 #include "opto/addnode.hpp"
 #include "opto/arraycopynode.hpp"
 #include "opto/callnode.hpp"
@@ -35,6 +36,7 @@
 #include "opto/graphKit.hpp"
 #include "opto/idealKit.hpp"
 #include "opto/macro.hpp"
+#include "opto/memnode.hpp"
 #include "opto/movenode.hpp"
 #include "opto/narrowptrnode.hpp"
 #include "opto/node.hpp"
@@ -132,7 +134,7 @@ void MMTkBarrierSetC2::expand_allocate(PhaseMacroExpand* x,
     }
   }
 
-  if (!MMTK_ENABLE_ALLOCATION_FASTPATH
+  if (!MMTkFastPaths::allocation(MMTK_FASTPATH_C2)
       // Malloc allocator has no fastpath
       || (selector.tag == TAG_MALLOC || selector.tag == TAG_LARGE_OBJECT)) {
     // Force slow-path allocation
@@ -448,6 +450,35 @@ void MMTkBarrierSetC2::expand_allocate(PhaseMacroExpand* x,
     result_phi_i_o = i_o; // Rename it to use in the following code.
   }
 
+  MMTkSlowPathSite* site = MMTkSlowPathCounters::new_site(MMTkSlowPathCounters::ALLOCATION, "c2", alloc->jvms()->method(), alloc->jvms()->bci());
+  if (site != NULL) {
+    // Count the slow-path calls of this allocation site: *counter += 1
+    Node* raw_mem = slow_mem->is_MergeMem() ? slow_mem->as_MergeMem()->memory_at(Compile::AliasIdxRaw) : slow_mem;
+
+    Node *counter = ConLNode::make((intptr_t) site->count_addr());
+    x->transform_later(counter);
+
+    Node *counter_p = new CastX2PNode(counter);
+    x->transform_later(counter_p);
+
+    Node *count = new LoadLNode(slow_region, raw_mem, counter_p, TypeRawPtr::BOTTOM, TypeLong::LONG, MemNode::unordered);
+    x->transform_later(count);
+
+    Node *const_one = ConLNode::make(1);
+    x->transform_later(const_one);
+
+    Node *new_count = new AddLNode(count, const_one);
+    x->transform_later(new_count);
+
+    Node *store_count = new StoreLNode(slow_region, raw_mem, counter_p, TypeRawPtr::BOTTOM, new_count, MemNode::unordered);
+    x->transform_later(store_count);
+
+    MergeMemNode *counted_mem = MergeMemNode::make(slow_mem);
+    counted_mem->set_memory_at(Compile::AliasIdxRaw, store_count);
+    x->transform_later(counted_mem);
+    slow_mem = counted_mem;
+  }
+
   // Generate slow-path call
   CallNode *call = new CallStaticJavaNode(slow_call_type, slow_call_address,
                                           OptoRuntime::stub_name(slow_call_address),
@@ -608,7 +639,7 @@ bool MMTkBarrierSetC2::can_remove_barrier(GraphKit* kit, PhaseTransform* phase,
     return true;
   }
   // Barrier elision based on allocation node does not working well with slowpath-only allocation.
-  if (!MMTK_ENABLE_ALLOCATION_FASTPATH) return false;
+  if (!MMTkFastPaths::allocation(MMTK_FASTPATH_C2)) return false;
   // No barrier required for newly allocated objects.
   if (src == kit->just_allocated_object(kit->control())) return true;
 
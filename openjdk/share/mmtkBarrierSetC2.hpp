@@ -53,6 +53,8 @@ protected:
   virtual void object_reference_write_pre(GraphKit* kit, Node* src, Node* slot, Node* val) const {}
   /// Full post-barrier
   virtual void object_reference_write_post(GraphKit* kit, Node* src, Node* slot, Node* val) const {}
+  /// Full clone post-barrier
+  virtual void object_reference_clone_post(GraphKit* kit, Node* src, Node* dst, bool is_array) const {}
 
   virtual Node* store_at_resolved(C2Access& access, C2AccessValue& val) const {
     if (access.is_oop() && access.is_parse_access()) {
@@ -88,9 +90,12 @@ protected:
 public:
   virtual void clone(GraphKit* kit, Node* src, Node* dst, Node* size, bool is_array) const {
     BarrierSetC2::clone(kit, src, dst, size, is_array);
+    object_reference_clone_post(kit, src, dst, is_array);
   }
+  /// Whether C2 must keep the barriers of an arraycopy or clone, instead of copying raw memory or
+  /// expanding a small copy into plain loads and stores. The base class has no barriers.
   virtual bool array_copy_requires_gc_barriers(bool tightly_coupled_alloc, BasicType type, bool is_clone, bool is_clone_instance, ArrayCopyPhase phase) const {
-    return true;
+    return false;
   }
   virtual bool is_gc_barrier_node(Node* node) const {
     if (node->Opcode() != Op_CallLeaf) return false;
@@ -117,10 +122,22 @@ public:
   using IdealKit::IdealKit;
   inline Node* LShiftX(Node* l, Node* r) { return transform(new LShiftXNode(l, r)); }
   inline Node* AndX(Node* l, Node* r) { return transform(new AndXNode(l, r)); }
+  inline Node* SubX(Node* l, Node* r) { return transform(new SubXNode(l, r)); }
   inline Node* ConvL2I(Node* x) { return transform(new ConvL2INode(x)); }
   inline Node* CastXP(Node* x) { return transform(new CastX2PNode(x)); }
   inline Node* URShiftI(Node* l, Node* r) { return transform(new URShiftINode(l, r)); }
+  inline Node* URShiftL(Node* l, Node* r) { return transform(new URShiftLNode(l, r)); }
+  inline Node* AndL(Node* l, Node* r) { return transform(new AndLNode(l, r)); }
   inline Node* ConP(intptr_t ptr) { return makecon(TypeRawPtr::make((address) ptr)); }
+  inline Node* ConL(jlong l) { return makecon(TypeLong::make(l)); }
+  inline Node* ConX(intptr_t x) { return makecon(TypeX::make(x)); }
+
+  /// Non-atomically increment the 64-bit counter at `counter`
+  inline void increment(address counter) {
+    Node* adr = ConP((intptr_t) counter);
+    Node* count = load(ctrl(), adr, TypeLong::LONG, T_LONG, Compile::AliasIdxRaw);
+    store(ctrl(), adr, transform(new AddLNode(count, ConL(1))), T_LONG, Compile::AliasIdxRaw, MemNode::unordered);
+  }
 
   template<class... Types>
   inline const TypeFunc* func_type(Types... types) {
@@ -0,0 +1,55 @@
+#include "precompiled.hpp"
+#include "code/nmethod.hpp"
+#include "gc/shared/barrierSet.hpp"
+#include "mmtk.h"
+#include "mmtkBarrierSetNMethod.hpp"
+#include "runtime/safepoint.hpp"
+
+// The number of locks shared by the nmethods. Must be a power of two.
+static const size_t NMETHOD_LOCK_COUNT = 1024;
+
+bool MMTkBarrierSetNMethod::_enabled = false;
+os::PlatformMutex* MMTkBarrierSetNMethod::_locks = NULL;
+
+void MMTkBarrierSetNMethod::initialize() {
+  _enabled = mmtk_nmethod_entry_barriers();
+  if (_enabled) {
+    _locks = new os::PlatformMutex[NMETHOD_LOCK_COUNT];
+  }
+}
+
+os::PlatformMutex* MMTkBarrierSetNMethod::lock_for_nmethod(nmethod* nm) {
+  // nmethods are at least word-aligned
+  return &_locks[((uintptr_t) nm >> LogBytesPerWord) & (NMETHOD_LOCK_COUNT - 1)];
+}
+
+bool MMTkBarrierSetNMethod::nmethod_entry_barrier(nmethod* nm) {
+  // Another thread may be patching the nmethod, or may have disarmed it since this thread saw it armed.
+  os::PlatformMutex* lock = lock_for_nmethod(nm);
+  lock->lock();
+  bool result = true;
+  if (is_armed(nm)) {
+    nm->fix_oop_relocations();
+    // Keeps the oops alive and disarms the nmethod
+    result = BarrierSetNMethod::nmethod_entry_barrier(nm);
+  }
+  lock->unlock();
+  return result;
+}
+
+void MMTkBarrierSetNMethod::fix_relocations(nmethod* nm, bool partial_stack_scanning) {
+  assert(SafepointSynchronize::is_at_safepoint(), "must be at safepoint");
+  // Unloaded by this GC. Its dead oops are never used again.
+  if (!nm->is_alive()) return;
+  BarrierSetNMethod* bs_nm = BarrierSet::barrier_set()->barrier_set_nmethod();
+  // A thread that returns into a frame of `nm` does not pass its entry barrier, so the nmethods
+  // on stacks are fixed now. Stack scanning claims the nmethods of the frames it visits.
+  // Partial stack scanning does not visit all the frames, and the nmethods of the skipped frames
+  // may still reference young objects (e.g. after Runtime1::patch_code registers them again), so
+  // all the nmethods are fixed now in that case.
+  if (_enabled && !partial_stack_scanning && bs_nm->supports_entry_barrier(nm) && nm->oops_do_try_claim()) {
+    bs_nm->arm(nm, bs_nm->disarmed_value() + 1);
+  } else {
+    nm->fix_oop_relocations();
+  }
+}
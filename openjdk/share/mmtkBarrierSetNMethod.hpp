@@ -0,0 +1,36 @@
+#ifndef MMTK_OPENJDK_MMTK_BARRIER_SET_NMETHOD_HPP
+#define MMTK_OPENJDK_MMTK_BARRIER_SET_NMETHOD_HPP
+
+#include "gc/shared/barrierSetNMethod.hpp"
+#include "runtime/os.hpp"
+
+class nmethod;
+
+/**
+ * nmethod entry barriers, enabled by `openjdk_nmethod_entry_barriers=true` in ThirdPartyHeapOptions.
+ *
+ * A GC updates the oop slots of the nmethods that reference moved objects, but the copies of
+ * those oops embedded in the code are only patched by `nmethod::fix_oop_relocations()`.
+ * With entry barriers, the pause arms these nmethods instead, and the first thread that enters
+ * an armed nmethod patches its code before running it.
+ */
+class MMTkBarrierSetNMethod: public BarrierSetNMethod {
+  static bool _enabled;
+  /// Striped locks that serialize the threads entering the same armed nmethod
+  static os::PlatformMutex* _locks;
+
+  static os::PlatformMutex* lock_for_nmethod(nmethod* nm);
+
+public:
+  static void initialize();
+  static bool enabled() { return _enabled; }
+
+  virtual bool nmethod_entry_barrier(nmethod* nm);
+
+  /// Fix the relocations of `nm`, whose oops were moved by the current GC.
+  /// Called by GC workers at the end of the GC. `partial_stack_scanning` tells whether
+  /// the current GC skipped the stack frames that have not run since the last GC.
+  static void fix_relocations(nmethod* nm, bool partial_stack_scanning);
+};
+
+#endif // MMTK_OPENJDK_MMTK_BARRIER_SET_NMETHOD_HPP
@@ -25,20 +25,30 @@
 #include "precompiled.hpp"
 #include "classfile/stringTable.hpp"
 #include "classfile/classLoaderDataGraph.hpp"
+#include "classfile/systemDictionary.hpp"
 #include "code/codeCache.hpp"
 #include "gc/shared/gcArguments.hpp"
 #include "gc/shared/gcHeapSummary.hpp"
 #include "gc/shared/gcLocker.inline.hpp"
 #include "gc/shared/gcWhen.hpp"
 #include "gc/shared/oopStorageSet.inline.hpp"
-#include "gc/shared/scavengableNMethods.hpp"
+#include "gc/shared/oopStorageSetParState.inline.hpp"
 #include "gc/shared/strongRootsScope.hpp"
-#include "gc/shared/weakProcessor.hpp"
+#include "gc/shared/weakProcessor.inline.hpp"
+#if INCLUDE_JVMCI
+#include "jvmci/jvmci.hpp"
+#endif
 #include "logging/log.hpp"
+#include "logging/logStream.hpp"
+#include "memory/metaspace.hpp"
 #include "memory/resourceArea.hpp"
 #include "mmtk.h"
+#include "mmtkBarrierSetNMethod.hpp"
 #include "mmtkHeap.hpp"
 #include "mmtkMutator.hpp"
+#include "mmtkRootsClosure.hpp"
+#include "mmtkSlowPathCounters.hpp"
+#include "mmtkStackWatermark.hpp"
 #include "mmtkUpcalls.hpp"
 #include "mmtkVMCompanionThread.hpp"
 #include "oops/oop.inline.hpp"
@@ -52,6 +62,7 @@
 #include "runtime/java.hpp"
 #include "runtime/thread.hpp"
 #include "runtime/threads.hpp"
+#include "runtime/threadSMR.hpp"
 #include "runtime/vmThread.hpp"
 #include "services/management.hpp"
 #include "services/memoryManager.hpp"
@@ -72,7 +83,7 @@ object iterator??!!
 
 MMTkHeap* MMTkHeap::_heap = NULL;
 
-MMTkHeap::MMTkHeap() : CollectedHeap(), _n_workers(0), _gc_lock(new Monitor(Mutex::safepoint, "MMTkHeap::_gc_lock", true)), _num_root_scan_tasks(0), _last_gc_time(0)
+MMTkHeap::MMTkHeap() : CollectedHeap(), _n_workers(0), _gc_lock(new Monitor(Mutex::safepoint, "MMTkHeap::_gc_lock", true)), _num_root_scan_tasks(0), _oop_storage_set_roots(NULL), _weak_processor_roots(NULL), _unloaded_classes(false), _last_gc_time(0)
 // , _par_state_string(StringTable::weak_storage())
 {
   _heap = this;
@@ -95,8 +106,18 @@ jint MMTkHeap::initialize() {
   guarantee(set_heap_size, "Failed to set MMTk heap size. Please check if the heap size is valid: %ld\n", heap_size);
 
   openjdk_gc_init(&mmtk_upcalls);
+  MMTkFastPaths::initialize();
+  MMTkSlowPathCounters::initialize();
+  MMTkStackWatermark::initialize();
+  MMTkBarrierSetNMethod::initialize();
+  LogTarget(Info, gc, init) lt;
+  if (lt.is_enabled()) {
+    LogStream ls(lt);
+    MMTkFastPaths::print_on(&ls);
+  }
   // Cache the value here. It is a constant depending on the selected plan. The plan won't change from now, so value won't change.
   MMTkMutatorContext::max_non_los_default_alloc_bytes = get_max_non_los_default_alloc_bytes();
+  MMTkMutatorContext::default_allocator_selector = get_allocator_mapping(AllocatorDefault);
 
   //ReservedSpace heap_rs = Universe::reserve_heap(mmtk_heap_size, _collector_policy->heap_alignment());
 
@@ -142,19 +163,8 @@ void MMTkHeap::schedule_finalizer() {
   MMTkFinalizerThread::instance->schedule();
 }
 
-class MMTkIsScavengable : public BoolObjectClosure {
-  bool do_object_b(oop obj) {
-    return true;
-  }
-};
-
-static MMTkIsScavengable _is_scavengable;
-
 void MMTkHeap::post_initialize() {
   CollectedHeap::post_initialize();
-
-
-  ScavengableNMethods::initialize(&_is_scavengable);
 }
 
 void MMTkHeap::enable_collection() {
@@ -353,6 +363,7 @@ void MMTkHeap::gc_threads_do(ThreadClosure* tc) const {
 // Default implementation does nothing.
 void MMTkHeap::print_tracing_info() const {
   //guarantee(false, "print tracing info not supported");
+  MMTkSlowPathCounters::print_on(tty);
 }
 
 // Used to print information about locations in the hs_err file.
@@ -382,6 +393,8 @@ void MMTkHeap::register_nmethod(nmethod* nm) {
 }
 // Callback for when nmethod is about to be deleted.
 void MMTkHeap::flush_nmethod(nmethod* nm) {
+  // Unloaded nmethods are already unregistered. Zombies may still be registered.
+  mmtk_unregister_nmethod((void*) nm);
 }
 void MMTkHeap::verify_nmethod(nmethod* nm) {
 }
@@ -397,27 +410,85 @@ void MMTkHeap::scan_code_cache_roots(OopClosure& cl) {
   MarkingCodeBlobClosure cb_cl(&cl, false, true);
   CodeCache::blobs_do(&cb_cl);
 }
-void MMTkHeap::scan_class_loader_data_graph_roots(OopClosure& cl) {
-  CLDToOopClosure cld_cl(&cl, false);
-  ClassLoaderDataGraph::cld_do(&cld_cl);
+void MMTkHeap::scan_class_loader_data_graph_roots(OopClosure& cl, bool class_unloading) {
+  // Several work packets walk the graph at the same time. Each CLD is scanned by the packet that claims it.
+  CLDToOopClosure cld_cl(&cl, ClassLoaderData::_claim_strong);
+  if (class_unloading) {
+    // Only the CLDs that are always alive are roots. The others are claimed and scanned
+    // when the GC reaches an object of one of their classes, a mirror or the class loader.
+    ClassLoaderDataGraph::always_strong_cld_do(&cld_cl);
+  } else {
+    ClassLoaderDataGraph::cld_do(&cld_cl);
+  }
+}
+void MMTkHeap::unload_classes() {
+  // Without class unloading, the code cache roots are strong and no nmethod is unloaded.
+  if (!ClassUnloading) return;
+  // The holders of the dead CLDs have been cleared by the weak processing.
+  bool purged_class = SystemDictionary::do_unloading(NULL);
+  // Unload the nmethods that reference dead objects. They are unregistered, and freed by the sweeper.
+  MMTkIsAliveClosure is_alive;
+  CodeCache::do_unloading(&is_alive, purged_class);
+  Klass::clean_weak_klass_links(purged_class);
+  JVMCI_ONLY(JVMCI::do_unloading(purged_class));
+  _unloaded_classes = true;
+}
+void MMTkHeap::purge_unloaded_classes() {
+  if (!_unloaded_classes) return;
+  _unloaded_classes = false;
+  ClassLoaderDataGraph::purge(true /* at_safepoint */);
+  MetaspaceGC::compute_new_size();
+}
+void MMTkOopStorageSetRoots::oops_do(OopClosure* cl) {
+  _par_state.oops_do(cl);
+}
+void MMTkHeap::start_oop_storage_set_scan() {
+  end_oop_storage_set_scan();
+  _oop_storage_set_roots = new MMTkOopStorageSetRoots();
+}
+void MMTkHeap::end_oop_storage_set_scan() {
+  delete _oop_storage_set_roots;
+  _oop_storage_set_roots = NULL;
 }
 void MMTkHeap::scan_oop_storage_set_roots(OopClosure& cl) {
-  OopStorageSet::strong_oops_do(&cl);
+  assert(_oop_storage_set_roots != NULL, "must be in a root scan");
+  _oop_storage_set_roots->oops_do(&cl);
 }
+// Report the weak roots as strong roots. Only used when MarkCompact re-scans the roots to update
+// them: the dead referents have already been cleared by `process_weak_processor_roots`.
 void MMTkHeap::scan_weak_processor_roots(OopClosure& cl) {
-  // XXX zixianc: I don't understand why this is removed in
-  // 24b90dd889da0ea58aaa2b2311ded6f262573830
-  // ResourceMark rm;
-  WeakProcessor::oops_do(&cl); // (really needed???)
+  WeakProcessor::oops_do(&cl);
+}
+void MMTkWeakProcessorRoots::process(uint worker_id) {
+  MMTkIsAliveClosure is_alive;
+  MMTkForwardClosure forward;
+  _task.work(worker_id, &is_alive, &forward);
+}
+void MMTkHeap::start_weak_processing() {
+  end_weak_processing();
+  _weak_processor_roots = new MMTkWeakProcessorRoots((uint) _n_workers);
+}
+void MMTkHeap::end_weak_processing() {
+  delete _weak_processor_roots;
+  _weak_processor_roots = NULL;
+}
+void MMTkHeap::process_weak_processor_roots(uint worker_id) {
+  assert(_weak_processor_roots != NULL, "must be in a GC");
+  _weak_processor_roots->process(worker_id);
 }
 void MMTkHeap::scan_vm_thread_roots(OopClosure& cl) {
   ResourceMark rm;
   VMThread::vm_thread()->oops_do(&cl, NULL);
 }
 
-void MMTkHeap::scan_thread_roots(OopClosure& cl) {
+void MMTkHeap::scan_thread_roots(OopClosure& cl, DerivedOopClosure* df) {
   ResourceMark rm;
-  Threads::possibly_parallel_oops_do(false, &cl, NULL);
+  MarkingCodeBlobClosure cb_cl(&cl, false, true);
+  // The VM thread roots are scanned by a separate work packet.
+  JavaThreadIteratorWithHandle jtiwh;
+  while (JavaThread* thread = jtiwh.next()) {
+    MMTkStackWatermark::oops_do(thread, &cl, &cb_cl, df, false);
+  }
 }
 
 void MMTkHeap::scan_roots(OopClosure& cl) {
@@ -31,8 +31,10 @@
 #include "gc/shared/gcWhen.hpp"
 #include "gc/shared/oopStorage.hpp"
 #include "gc/shared/oopStorageParState.hpp"
+#include "gc/shared/oopStorageSetParState.hpp"
 #include "gc/shared/space.hpp"
 #include "gc/shared/strongRootsScope.hpp"
+#include "gc/shared/weakProcessor.hpp"
 #include "memory/iterator.hpp"
 #include "memory/metaspace.hpp"
 #include "mmtkFinalizerThread.hpp"
@@ -44,6 +46,25 @@ class GCMemoryManager;
 class MemoryPool;
 //class mmtkGCTaskManager;
 class MMTkVMCompanionThread;
+
+/// The claim state of the OopStorageSet strong roots for one root scan.
+/// The root-scanning packets share it, and each claims its own ranges of blocks.
+class MMTkOopStorageSetRoots: public CHeapObj<mtGC> {
+  OopStorageSetStrongParState<false /* concurrent */, false /* is_const */> _par_state;
+public:
+  void oops_do(OopClosure* cl);
+};
+
+/// The weak OopStorage roots of one GC. After the transitive closure, each GC worker
+/// processes its share of the slots: dead referents are cleared, and live ones are forwarded.
+/// Freeing it reports the number of dead slots to the owners of the storages, which clean up their tables.
+class MMTkWeakProcessorRoots: public CHeapObj<mtGC> {
+  WeakProcessor::Task _task;
+public:
+  MMTkWeakProcessorRoots(uint nworkers): _task(nworkers) {}
+  void process(uint worker_id);
+};
+
 class MMTkHeap : public CollectedHeap {
   SoftRefPolicy* _soft_ref_policy;
   MMTkMemoryPool* _mmtk_pool;
@@ -56,6 +77,9 @@ class MMTkHeap : public CollectedHeap {
   ContiguousSpace* _space;
   int _num_root_scan_tasks;
   MMTkVMCompanionThread* _companion_thread;
+  MMTkOopStorageSetRoots* _oop_storage_set_roots;
+  MMTkWeakProcessorRoots* _weak_processor_roots;
+  bool _unloaded_classes;
 public:
 
   MMTkHeap();
@@ -98,7 +122,8 @@ public:
   bool supports_tlab_allocation() const;
 
   bool supports_inline_contig_alloc() const {
-    return MMTK_ENABLE_ALLOCATION_FASTPATH;
+    // Both the interpreter and C1 use `eden_allocate`, which falls back to the slow-path for a tier without the fast-path.
+    return MMTkFastPaths::allocation(MMTK_FASTPATH_INTERPRETER) || MMTkFastPaths::allocation(MMTK_FASTPATH_C1);
   }
 
   // The amount of space available for thread-local allocation buffers.
@@ -194,12 +219,22 @@ public:
 
   void scan_roots(OopClosure& cl);
 
-  void scan_thread_roots(OopClosure& cl);
+  void scan_thread_roots(OopClosure& cl, DerivedOopClosure* df);
 
   void scan_code_cache_roots(OopClosure& cl);
-  void scan_class_loader_data_graph_roots(OopClosure& cl);
+  void scan_class_loader_data_graph_roots(OopClosure& cl, bool class_unloading);
+  /// Unload the classes whose class loaders died in this GC. Runs after the weak roots are processed.
+  void unload_classes();
+  /// Free the metaspace of the unloaded classes. Called before the mutators are resumed.
+  void purge_unloaded_classes();
   void scan_oop_storage_set_roots(OopClosure& cl);
+  /// Reset the claims of the OopStorageSet roots before each root scan, and free them after the GC.
+  void start_oop_storage_set_scan();
+  void end_oop_storage_set_scan();
   void scan_weak_processor_roots(OopClosure& cl);
+  void process_weak_processor_roots(uint worker_id);
+  void start_weak_processing();
+  void end_weak_processing();
   void scan_vm_thread_roots(OopClosure& cl);
 
   jlong _last_gc_time;
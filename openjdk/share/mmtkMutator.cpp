@@ -1,9 +1,12 @@
 
 #include "precompiled.hpp"
 #include "mmtk.h"
+#include "mmtkBarrierSet.hpp"
 #include "mmtkMutator.hpp"
+#include "mmtkSlowPathCounters.hpp"
 
 size_t MMTkMutatorContext::max_non_los_default_alloc_bytes = 0;
+AllocatorSelector MMTkMutatorContext::default_allocator_selector = { 0, 0 };
 
 MMTkMutatorContext MMTkMutatorContext::bind(::Thread* current) {
   return *((MMTkMutatorContext*) ::bind_mutator((void*) current));
@@ -14,6 +17,14 @@ bool MMTkMutatorContext::is_ready_to_bind() {
 }
 
 HeapWord* MMTkMutatorContext::alloc(size_t bytes, Allocator allocator) {
+#ifdef ZERO
+  // The Zero interpreter has no generated code, so its allocation fast-path is here.
+  if (MMTkFastPaths::allocation(MMTK_FASTPATH_INTERPRETER)) {
+    HeapWord* o = alloc_fast(bytes, allocator);
+    if (o != nullptr) return o;
+  }
+#endif
+  if (MMTkSlowPathCounters::enabled()) MMTkSlowPathCounters::count_allocation_slow();
   // All allocations with size larger than max non-los bytes will get to this slowpath here.
   // We will use LOS for those.
   assert(MMTkMutatorContext::max_non_los_default_alloc_bytes != 0, "max_non_los_default_alloc_bytes hasn't been initialized");
@@ -31,6 +42,46 @@ HeapWord* MMTkMutatorContext::alloc(size_t bytes, Allocator allocator) {
   return o;
 }
 
+HeapWord* MMTkMutatorContext::alloc_fast(size_t bytes, Allocator allocator) {
+  if (allocator != AllocatorDefault) return nullptr;
+
+  AllocatorSelector selector = MMTkMutatorContext::default_allocator_selector;
+  void** cursor;
+  void** limit;
+  size_t extra_header = 0;
+  if (selector.tag == TAG_IMMIX) {
+    cursor = &allocators.immix[selector.index].cursor;
+    limit = &allocators.immix[selector.index].limit;
+  } else if (selector.tag == TAG_BUMP_POINTER) {
+    cursor = &allocators.bump_pointer[selector.index].cursor;
+    limit = &allocators.bump_pointer[selector.index].limit;
+  } else if (selector.tag == TAG_MARK_COMPACT) {
+    cursor = &allocators.markcompact[selector.index].bump_allocator.cursor;
+    limit = &allocators.markcompact[selector.index].bump_allocator.limit;
+    extra_header = MMTK_MARK_COMPACT_HEADER_RESERVED_IN_BYTES;
+  } else {
+    // Malloc and large object allocators have no fast-path
+    return nullptr;
+  }
+  // Objects that need to go to LOS take the slow-path
+  if (bytes >= MMTkMutatorContext::max_non_los_default_alloc_bytes - extra_header) return nullptr;
+
+  uintptr_t obj = (uintptr_t) *cursor + extra_header;
+  uintptr_t end = obj + bytes;
+  if (end < obj || end > (uintptr_t) *limit) return nullptr;
+  *cursor = (void*) end;
+
+  bool enable_global_alloc_bit = false;
+#ifdef MMTK_ENABLE_GLOBAL_ALLOC_BIT
+  enable_global_alloc_bit = true;
+#endif
+  if (enable_global_alloc_bit || selector.tag == TAG_MARK_COMPACT) {
+    uint8_t* meta_addr = (uint8_t*) (ALLOC_BIT_BASE_ADDRESS + (obj >> 6));
+    *meta_addr |= (uint8_t) (1 << ((obj >> 3) & 0b111));
+  }
+  return (HeapWord*) obj;
+}
+
 void MMTkMutatorContext::flush() {
   ::flush_mutator((MMTk_Mutator) this);
 }
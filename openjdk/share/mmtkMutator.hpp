@@ -90,6 +90,9 @@ struct MMTkMutatorContext {
   MutatorConfig config;
 
   HeapWord* alloc(size_t bytes, Allocator allocator = AllocatorDefault);
+  /// Bump-pointer allocation without calling into MMTk. Same as the eden_allocate fast-path of the assemblers.
+  /// Returns NULL if the allocation has to go to the slow-path. Only used by Zero, which has no assembler.
+  HeapWord* alloc_fast(size_t bytes, Allocator allocator);
 
   void flush();
 
@@ -98,5 +101,7 @@ struct MMTkMutatorContext {
 
   // Max object size that does not need to go into LOS. We get the value from mmtk-core, and cache its value here.
   static size_t max_non_los_default_alloc_bytes;
+  // The MMTk allocator used for AllocatorDefault. Same as above, it depends on the selected plan and is cached here.
+  static AllocatorSelector default_allocator_selector;
 };
 #endif // MMTK_OPENJDK_MMTK_MUTATOR_HPP
@@ -1,11 +1,14 @@
 #ifndef MMTK_OPENJDK_MMTK_ROOTS_CLOSURE_HPP
 #define MMTK_OPENJDK_MMTK_ROOTS_CLOSURE_HPP
 
+#include "classfile/classLoaderData.hpp"
+#include "compiler/oopMap.hpp"
 #include "memory/iterator.hpp"
 #include "mmtk.h"
 #include "oops/oop.hpp"
 #include "oops/oop.inline.hpp"
 #include "utilities/globalDefinitions.hpp"
+#include "utilities/growableArray.hpp"
 
 #define ROOTS_BUFFER_SIZE 4096
 
@@ -94,6 +97,60 @@ public:
   virtual void do_oop(narrowOop* p) { do_oop_work(p); }
 };
 
+/// Record the derived pointers of the compiled frames scanned by one work packet.
+/// A derived pointer points into an object, at an offset from a base oop in the same frame.
+/// It is updated once the base has been forwarded, by the worker that runs `update()`,
+/// instead of going through the global DerivedPointerTable.
+class MMTkDerivedPointerClosure: public DerivedOopClosure {
+  struct Entry {
+    oop* _base;
+    derived_pointer* _derived;
+    intptr_t _offset;
+  };
+  typedef GrowableArrayCHeap<Entry, mtGC> Entries;
+  Entries* _entries;
+
+public:
+  MMTkDerivedPointerClosure(): _entries(NULL) {}
+  ~MMTkDerivedPointerClosure() { delete _entries; }
+
+  virtual void do_derived_oop(oop* base, derived_pointer* derived) {
+    if (_entries == NULL) _entries = new Entries(32);
+    Entry entry = { base, derived, static_cast<intptr_t>(*derived) - cast_from_oop<intptr_t>(*base) };
+    _entries->append(entry);
+  }
+
+  /// Hand over the recorded pointers, to be passed to `update()`. NULL if there are none.
+  void* release() {
+    Entries* entries = _entries;
+    _entries = NULL;
+    return (void*) entries;
+  }
+
+  /// Update the derived pointers returned by `release()` from their forwarded bases, and free them.
+  static void update(void* entries) {
+    Entries* list = (Entries*) entries;
+    for (int i = 0; i < list->length(); i++) {
+      const Entry& entry = list->at(i);
+      *entry._derived = static_cast<derived_pointer>(cast_from_oop<intptr_t>(*entry._base) + entry._offset);
+    }
+    delete list;
+  }
+};
+
+/// Whether an object survived the current GC
+class MMTkIsAliveClosure: public BoolObjectClosure {
+public:
+  virtual bool do_object_b(oop obj) { return mmtk_is_live((void*) obj); }
+};
+
+/// Update a slot that references a surviving object to the object's new location
+class MMTkForwardClosure: public OopClosure {
+public:
+  virtual void do_oop(oop* p) { *p = (oop) mmtk_get_forwarded_object((void*) *p); }
+  virtual void do_oop(narrowOop* p) { ShouldNotReachHere(); }
+};
+
 class MMTkScanObjectClosure : public BasicOopIterateClosure {
   void* _trace;
   CLDToOopClosure follow_cld_closure;
@@ -105,7 +162,7 @@ class MMTkScanObjectClosure : public BasicOopIterateClosure {
   }
 
 public:
-  MMTkScanObjectClosure(void* trace): _trace(trace), follow_cld_closure(this, false) {}
+  MMTkScanObjectClosure(void* trace): _trace(trace), follow_cld_closure(this, ClassLoaderData::_claim_strong) {}
 
   virtual void do_oop(oop* p)       { do_oop_work(p); }
   virtual void do_oop(narrowOop* p) {
@@ -118,10 +175,7 @@ public:
   }
 
   virtual void do_klass(Klass* k) {
-  //  follow_cld_closure.do_cld(k->class_loader_data());
-    // oop op = k->klass_holder();
-    // oop new_op = (oop) trace_root_object(_trace, op);
-    // guarantee(new_op == op, "trace_root_object returned a different value %p -> %p", op, new_op);
+    do_cld(k->class_loader_data());
   }
 
   virtual void do_cld(ClassLoaderData* cld) {
@@ -140,14 +194,4 @@ public:
 //   }
 // };
 
-class CodeBlobFixRelocationClosure: public CodeBlobClosure {
- public:
-  inline virtual void do_code_blob(CodeBlob* cb) {
-    nmethod* nm = cb->as_nmethod_or_null();
-    if (nm != NULL) {
-      nm->fix_oop_relocations();
-    }
-  }
-};
-
 #endif // MMTK_OPENJDK_MMTK_ROOTS_CLOSURE_HPP
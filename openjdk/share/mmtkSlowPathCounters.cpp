@@ -0,0 +1,87 @@
+#include "precompiled.hpp"
+#include "ci/ciMethod.hpp"
+#include "memory/resourceArea.hpp"
+#include "mmtk.h"
+#include "mmtkSlowPathCounters.hpp"
+#include "runtime/atomic.hpp"
+#include "runtime/os.hpp"
+
+/// Slow-path calls made by one thread. Never freed, so that the counts of exited threads are kept.
+struct MMTkThreadSlowPathCounters: public CHeapObj<mtGC> {
+  volatile jlong barrier;
+  volatile jlong allocation;
+  MMTkThreadSlowPathCounters* next;
+};
+
+static MMTkThreadSlowPathCounters* volatile _thread_counters_list = NULL;
+static THREAD_LOCAL MMTkThreadSlowPathCounters* _thread_counters = NULL;
+
+static MMTkThreadSlowPathCounters* thread_counters() {
+  if (_thread_counters == NULL) {
+    MMTkThreadSlowPathCounters* counters = new MMTkThreadSlowPathCounters();
+    counters->barrier = 0;
+    counters->allocation = 0;
+    MMTkThreadSlowPathCounters* old_head;
+    do {
+      old_head = Atomic::load(&_thread_counters_list);
+      counters->next = old_head;
+    } while (Atomic::cmpxchg(&_thread_counters_list, old_head, counters) != old_head);
+    _thread_counters = counters;
+  }
+  return _thread_counters;
+}
+
+bool MMTkSlowPathCounters::_enabled = false;
+MMTkSlowPathSite* volatile MMTkSlowPathCounters::_sites = NULL;
+const char* MMTkSlowPathCounters::BARRIER = "barrier";
+const char* MMTkSlowPathCounters::ALLOCATION = "allocation";
+
+void MMTkSlowPathCounters::initialize() {
+  _enabled = mmtk_count_slow_paths();
+}
+
+MMTkSlowPathSite* MMTkSlowPathCounters::new_site(const char* kind, const char* tier, ciMethod* method, int bci) {
+  if (!_enabled) return NULL;
+  MMTkSlowPathSite* site = new MMTkSlowPathSite();
+  site->_kind = kind;
+  site->_tier = tier;
+  {
+    ResourceMark rm;
+    stringStream ss;
+    method->print_short_name(&ss);
+    site->_method = os::strdup(ss.as_string(), mtGC);
+  }
+  site->_bci = bci;
+  site->_count = 0;
+  MMTkSlowPathSite* old_head;
+  do {
+    old_head = Atomic::load(&_sites);
+    site->_next = old_head;
+  } while (Atomic::cmpxchg(&_sites, old_head, site) != old_head);
+  return site;
+}
+
+void MMTkSlowPathCounters::count_barrier_slow() {
+  thread_counters()->barrier++;
+}
+
+void MMTkSlowPathCounters::count_allocation_slow() {
+  thread_counters()->allocation++;
+}
+
+void MMTkSlowPathCounters::print_on(outputStream* st) {
+  if (!_enabled) return;
+  jlong barrier = 0, allocation = 0;
+  int threads = 0;
+  for (MMTkThreadSlowPathCounters* c = Atomic::load(&_thread_counters_list); c != NULL; c = c->next) {
+    barrier += c->barrier;
+    allocation += c->allocation;
+    threads++;
+  }
+  st->print_cr("MMTk slow-path calls (%d threads): barrier " JLONG_FORMAT ", allocation " JLONG_FORMAT, threads, barrier, allocation);
+  st->print_cr("MMTk slow-path calls per compiled site:");
+  for (MMTkSlowPathSite* site = Atomic::load(&_sites); site != NULL; site = site->_next) {
+    if (site->_count == 0) continue;
+    st->print_cr("  " JLONG_FORMAT_W(12) " %-10s %-3s %s @ %d", site->_count, site->_kind, site->_tier, site->_method, site->_bci);
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef MMTK_OPENJDK_MMTK_SLOW_PATH_COUNTERS_HPP
+#define MMTK_OPENJDK_MMTK_SLOW_PATH_COUNTERS_HPP
+
+#include "memory/allocation.hpp"
+#include "utilities/globalDefinitions.hpp"
+#include "utilities/ostream.hpp"
+
+class ciMethod;
+
+/// A barrier or allocation slow-path branch in compiled code.
+/// Compiled code increments `_count` (non-atomically) every time the branch is taken.
+class MMTkSlowPathSite: public CHeapObj<mtGC> {
+  friend class MMTkSlowPathCounters;
+  const char* _kind;
+  const char* _tier;
+  char* _method;
+  int _bci;
+  volatile jlong _count;
+  MMTkSlowPathSite* _next;
+public:
+  address count_addr() { return (address) &_count; }
+};
+
+/**
+ * Opt-in slow-path counters, enabled by `openjdk_count_slow_paths=true` in ThirdPartyHeapOptions.
+ *
+ * C1 and C2 emit an increment of a per-site counter on their slow-path branches.
+ * The runtime slow-path entries also count calls per thread, which covers the interpreter.
+ * All counters are printed when the VM exits.
+ */
+class MMTkSlowPathCounters: AllStatic {
+  static bool _enabled;
+  static MMTkSlowPathSite* volatile _sites;
+
+public:
+  static const char* BARRIER;
+  static const char* ALLOCATION;
+
+  static void initialize();
+  static bool enabled() { return _enabled; }
+
+  /// Register a new compiled site. Returns NULL if counting is disabled.
+  static MMTkSlowPathSite* new_site(const char* kind, const char* tier, ciMethod* method, int bci);
+
+  /// Count a call to a runtime slow-path entry for the current thread.
+  static void count_barrier_slow();
+  static void count_allocation_slow();
+
+  static void print_on(outputStream* st);
+};
+
+#endif // MMTK_OPENJDK_MMTK_SLOW_PATH_COUNTERS_HPP
@@ -0,0 +1,37 @@
+#include "precompiled.hpp"
+#include "mmtk.h"
+#include "mmtkStackWatermark.hpp"
+#include "runtime/atomic.hpp"
+#include "runtime/frame.inline.hpp"
+#include "runtime/stackWatermark.inline.hpp"
+#include "runtime/stackWatermarkSet.inline.hpp"
+#include "runtime/thread.inline.hpp"
+
+bool MMTkStackWatermark::_enabled = false;
+volatile uint32_t MMTkStackWatermark::_epoch = 0;
+
+void MMTkStackWatermark::initialize() {
+  _enabled = mmtk_partial_stack_scanning();
+}
+
+void MMTkStackWatermark::oops_do(JavaThread* jt, OopClosure* cl, CodeBlobClosure* cb_cl, DerivedOopClosure* df, bool partial) {
+  StackWatermark* watermark = _enabled && partial ? StackWatermarkSet::get(jt, StackWatermarkKind::gc) : NULL;
+  // Scan the whole stack if the thread has been created since the last GC, if all of its frames have run,
+  // or if it has mounted continuations, whose frames can be thawed above the watermark.
+  if (watermark != NULL
+      && ((watermark->processing_started() && watermark->processing_completed()) || jt->last_continuation() != NULL)) {
+    watermark = NULL;
+  }
+  // The rest is JavaThread::oops_do, without first finishing the (no-op) lazy processing of all frames,
+  // and with the derived pointers reported to `df` instead of the global DerivedPointerTable.
+  jt->oops_do_no_frames(cl, cb_cl);
+  if (!jt->has_last_Java_frame()) return;
+  // No frame has run since the last GC.
+  if (watermark != NULL && !watermark->processing_started()) return;
+  uintptr_t wm = watermark != NULL ? watermark->watermark() : UINTPTR_MAX;
+  for (StackFrameStream fst(jt, true /* update */, false /* process_frames */); !fst.is_done(); fst.next()) {
+    fst.current()->oops_do(cl, cb_cl, df, fst.register_map());
+    // The first frame above the watermark is scanned as well, as it holds the arguments of the frame below it.
+    if ((uintptr_t) fst.current()->sp() > wm) break;
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef MMTK_OPENJDK_MMTK_STACK_WATERMARK_HPP
+#define MMTK_OPENJDK_MMTK_STACK_WATERMARK_HPP
+
+#include "memory/iterator.hpp"
+#include "runtime/atomic.hpp"
+#include "runtime/stackWatermark.hpp"
+
+class JavaThread;
+
+/**
+ * Partial thread-stack scanning, enabled by `openjdk_partial_stack_scanning=true` in ThirdPartyHeapOptions.
+ *
+ * Every GC starts a new watermark epoch. When a thread runs again, HotSpot's stack watermark
+ * framework marks its top frames as processed, and marks each older frame as processed when the
+ * thread returns or unwinds into it, or when another thread walks it. Frames above the watermark
+ * have not run since the last GC. Every reference in them was visited by an earlier GC and points
+ * to a mature object, so a nursery GC only needs to scan the frames below the watermark.
+ */
+class MMTkStackWatermark: public StackWatermark {
+  static bool _enabled;
+  static volatile uint32_t _epoch;
+
+protected:
+  virtual uint32_t epoch_id() const { return Atomic::load(&_epoch); }
+  /// Nothing to do: processing a frame only moves the watermark past it.
+  virtual void process(const frame& fr, RegisterMap& register_map, void* context) {}
+
+public:
+  MMTkStackWatermark(JavaThread* jt): StackWatermark(jt, StackWatermarkKind::gc, Atomic::load(&_epoch)) {}
+
+  static void initialize();
+  static bool enabled() { return _enabled; }
+  /// Start a new epoch. Called in the pause, before the mutators are resumed.
+  static void on_gc_end() { Atomic::inc(&_epoch); }
+
+  /// Visit the roots of `jt`. If `partial`, skip the frames that have not run since the last GC.
+  /// The derived pointers of compiled frames are reported to `df`.
+  static void oops_do(JavaThread* jt, OopClosure* cl, CodeBlobClosure* cb_cl, DerivedOopClosure* df, bool partial);
+};
+
+#endif // MMTK_OPENJDK_MMTK_STACK_WATERMARK_HPP
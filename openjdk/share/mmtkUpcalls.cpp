@@ -23,15 +23,19 @@
  */
 
 #include "precompiled.hpp"
+#include "classfile/classLoaderData.inline.hpp"
 #include "classfile/classLoaderDataGraph.hpp"
+#include "classfile/javaClasses.inline.hpp"
 #include "classfile/stringTable.hpp"
 #include "code/nmethod.hpp"
 #include "memory/iterator.inline.hpp"
 #include "memory/resourceArea.hpp"
+#include "mmtkBarrierSetNMethod.hpp"
 #include "mmtkCollectorThread.hpp"
 #include "mmtkContextThread.hpp"
 #include "mmtkHeap.hpp"
 #include "mmtkRootsClosure.hpp"
+#include "mmtkStackWatermark.hpp"
 #include "mmtkUpcalls.hpp"
 #include "mmtkVMCompanionThread.hpp"
 #include "oops/access.hpp"
@@ -51,41 +55,28 @@
 // Note: This counter must be accessed using the Atomic class.
 static volatile size_t mmtk_start_the_world_count = 0;
 
-static void mmtk_stop_all_mutators(void *tls, bool scan_mutators_in_safepoint, MutatorClosure closure) {
-  ClassLoaderDataGraph::clear_claimed_marks();
-#if COMPILER2_OR_JVMCI
-  DerivedPointerTable::clear();
-#endif
-
+// The mutators are enumerated by the caller, from a snapshot taken with mmtk_get_mutators.
+static void mmtk_stop_all_mutators(void *tls) {
   log_debug(gc)("Requesting the VM to suspend all mutators...");
   MMTkHeap::heap()->companion_thread()->request(MMTkVMCompanionThread::_threads_suspended, true);
-  log_debug(gc)("Mutators stopped. Now enumerate threads for scanning...");
-
-  if (!scan_mutators_in_safepoint) {
-    JavaThreadIteratorWithHandle jtiwh;
-    while (JavaThread *cur = jtiwh.next()) {
-      closure.invoke((void*)&cur->third_party_heap_mutator);
-    }
-  }
-  log_debug(gc)("Finished enumerating threads.");
+  log_debug(gc)("Mutators stopped.");
   nmethod::oops_do_marking_prologue();
+  MMTkHeap::heap()->start_oop_storage_set_scan();
+  MMTkHeap::heap()->start_weak_processing();
 }
 
 static void mmtk_resume_mutators(void *tls) {
   nmethod::oops_do_marking_epilogue();
-  // ClassLoaderDataGraph::purge();
-#if COMPILER2_OR_JVMCI
-  DerivedPointerTable::update_pointers();
-#endif
-  {
-    CodeBlobFixRelocationClosure cb_cl;
-    CodeCache::blobs_do(&cb_cl);
-  }
+  MMTkHeap::heap()->end_oop_storage_set_scan();
+  MMTkHeap::heap()->end_weak_processing();
+  MMTkHeap::heap()->purge_unloaded_classes();
 
   // Note: we don't have to hold gc_lock to increment the counter.
   // The increment has to be done before mutators can be resumed
   // otherwise, mutators might see a stale value
   Atomic::inc(&mmtk_start_the_world_count);
+  // Frames that run from now on are marked by the stack watermarks of the new epoch.
+  MMTkStackWatermark::on_gc_end();
 
   log_debug(gc)("Requesting the VM to resume all mutators...");
   MMTkHeap::heap()->companion_thread()->request(MMTkVMCompanionThread::_threads_resumed, true);
@@ -184,51 +175,37 @@ static bool mmtk_is_mutator(void* tls) {
   return ((Thread*) tls)->third_party_heap_collector == NULL;
 }
 
-template <class T>
-struct MaybeUninit {
-  MaybeUninit() {}
-  T* operator->() {
-    return (T*) &_data;
-  }
-  T& operator*() {
-    return *((T*) &_data);
-  }
-private:
-  char _data[sizeof(T)];
-};
-
-static MaybeUninit<JavaThreadIteratorWithHandle> jtiwh;
-static bool mutator_iteration_start = true;
-
-static void* mmtk_get_next_mutator() {
-  if (mutator_iteration_start) {
-    *jtiwh = JavaThreadIteratorWithHandle();
-    mutator_iteration_start = false;
-  }
-  JavaThread *thr = jtiwh->next();
-  if (thr == NULL) {
-    mutator_iteration_start = true;
-    return NULL;
+// Store the mutators of all Java threads into `mutators`, up to `capacity` of them.
+// Returns the number of Java threads. If it exceeds `capacity`, the caller retries with a larger array.
+static size_t mmtk_get_mutators(void** mutators, size_t capacity) {
+  ThreadsListHandle tlh;
+  size_t length = tlh.length();
+  for (size_t i = 0; i < length && i < capacity; i++) {
+    mutators[i] = (void*) &tlh.thread_at(i)->third_party_heap_mutator;
   }
-  return (void*) &thr->third_party_heap_mutator;
-}
-
-static void mmtk_reset_mutator_iterator() {
-  mutator_iteration_start = true;
+  return length;
 }
 
 
-static void mmtk_scan_all_thread_roots(EdgesClosure closure) {
+static void* mmtk_scan_all_thread_roots(EdgesClosure closure) {
   MMTkRootsClosure2 cl(closure);
-  MMTkHeap::heap()->scan_thread_roots(cl);
+  MMTkDerivedPointerClosure df;
+  MMTkHeap::heap()->scan_thread_roots(cl, &df);
+  return df.release();
 }
 
-static void mmtk_scan_thread_roots(EdgesClosure closure, void* tls) {
+static void* mmtk_scan_thread_roots(EdgesClosure closure, void* tls, bool partial) {
   ResourceMark rm;
   JavaThread* thread = (JavaThread*) tls;
   MMTkRootsClosure2 cl(closure);
   MarkingCodeBlobClosure cb_cl(&cl, false, true);
-  thread->oops_do(&cl, &cb_cl);
+  MMTkDerivedPointerClosure df;
+  MMTkStackWatermark::oops_do(thread, &cl, &cb_cl, &df, partial);
+  return df.release();
+}
+
+static void mmtk_update_derived_pointers(void* derived_pointers) {
+  MMTkDerivedPointerClosure::update(derived_pointers);
 }
 
 static void mmtk_scan_object(void* trace, void* object, void* tls) {
@@ -315,9 +292,32 @@ static void mmtk_schedule_finalizer() {
 }
 
 static void mmtk_scan_code_cache_roots(EdgesClosure closure) { MMTkRootsClosure2 cl(closure); MMTkHeap::heap()->scan_code_cache_roots(cl); }
-static void mmtk_scan_class_loader_data_graph_roots(EdgesClosure closure) { MMTkRootsClosure2 cl(closure); MMTkHeap::heap()->scan_class_loader_data_graph_roots(cl); }
+static void mmtk_fix_nmethod_relocations(void* nm, bool partial_stack_scanning) { MMTkBarrierSetNMethod::fix_relocations((nmethod*) nm, partial_stack_scanning); }
+static void mmtk_scan_class_loader_data_graph_roots(EdgesClosure closure, bool class_unloading) { MMTkRootsClosure2 cl(closure); MMTkHeap::heap()->scan_class_loader_data_graph_roots(cl, class_unloading); }
+static void mmtk_scan_class_loader_data(void* cld, EdgesClosure closure) {
+  ClassLoaderData* data = (ClassLoaderData*) cld;
+  if (data->try_claim(ClassLoaderData::_claim_strong)) {
+    MMTkRootsClosure2 cl(closure);
+    data->oops_do(&cl, ClassLoaderData::_claim_none);
+  }
+}
+// The class loader data kept alive by a java.lang.Class or a java.lang.ClassLoader object.
+static void* mmtk_class_loader_data_of(void* object) {
+  oop obj = (oop) object;
+  if (java_lang_Class::is_instance(obj)) {
+    // NULL for primitive mirrors, and for classes that are not fully loaded.
+    Klass* klass = java_lang_Class::as_Klass(obj);
+    return klass != NULL ? klass->class_loader_data() : NULL;
+  }
+  // NULL for class loaders that have not defined any class yet.
+  return java_lang_ClassLoader::loader_data_raw(obj);
+}
+static bool mmtk_class_unloading_enabled() { return ClassUnloading; }
+static void mmtk_unload_classes() { MMTkHeap::heap()->unload_classes(); }
+static void mmtk_clear_claimed_cld_marks() { ClassLoaderDataGraph::clear_claimed_marks(); }
 static void mmtk_scan_oop_storage_set_roots(EdgesClosure closure) { MMTkRootsClosure2 cl(closure); MMTkHeap::heap()->scan_oop_storage_set_roots(cl); }
 static void mmtk_scan_weak_processor_roots(EdgesClosure closure) { MMTkRootsClosure2 cl(closure); MMTkHeap::heap()->scan_weak_processor_roots(cl); }
+static void mmtk_process_weak_processor_roots(size_t worker_id) { MMTkHeap::heap()->process_weak_processor_roots((uint) worker_id); }
 static void mmtk_scan_vm_thread_roots(EdgesClosure closure) { MMTkRootsClosure2 cl(closure); MMTkHeap::heap()->scan_vm_thread_roots(cl); }
 
 static size_t mmtk_number_of_mutators() {
@@ -325,10 +325,8 @@ static size_t mmtk_number_of_mutators() {
 }
 
 static void mmtk_prepare_for_roots_re_scanning() {
-#if COMPILER2_OR_JVMCI
-  DerivedPointerTable::update_pointers();
-  DerivedPointerTable::clear();
-#endif
+  ClassLoaderDataGraph::clear_claimed_marks();
+  MMTkHeap::heap()->start_oop_storage_set_scan();
 }
 
 static void mmtk_enqueue_references(void** objects, size_t len) {
@@ -358,8 +356,7 @@ OpenJDK_Upcalls mmtk_upcalls = {
   mmtk_spawn_gc_thread,
   mmtk_block_for_gc,
   mmtk_out_of_memory,
-  mmtk_get_next_mutator,
-  mmtk_reset_mutator_iterator,
+  mmtk_get_mutators,
   mmtk_scan_object,
   mmtk_dump_object,
   mmtk_get_object_size,
@@ -375,10 +372,18 @@ OpenJDK_Upcalls mmtk_upcalls = {
   dump_object_string,
   mmtk_scan_all_thread_roots,
   mmtk_scan_thread_roots,
+  mmtk_update_derived_pointers,
   mmtk_scan_code_cache_roots,
+  mmtk_fix_nmethod_relocations,
   mmtk_scan_class_loader_data_graph_roots,
+  mmtk_scan_class_loader_data,
+  mmtk_class_loader_data_of,
+  mmtk_class_unloading_enabled,
+  mmtk_unload_classes,
+  mmtk_clear_claimed_cld_marks,
   mmtk_scan_oop_storage_set_roots,
   mmtk_scan_weak_processor_roots,
+  mmtk_process_weak_processor_roots,
   mmtk_scan_vm_thread_roots,
   mmtk_number_of_mutators,
   mmtk_schedule_finalizer,
@@ -25,13 +25,21 @@
 #include "precompiled.hpp"
 #include "mmtk.h"
 #include "mmtkVMCompanionThread.hpp"
+#include "runtime/atomic.hpp"
 #include "runtime/mutex.hpp"
+#include "runtime/os.hpp"
 #include "logging/log.hpp"
 
 MMTkVMCompanionThread::MMTkVMCompanionThread():
     NamedThread(),
     _desired_state(_threads_resumed),
-    _reached_state(_threads_resumed) {
+    _reached_state(_threads_resumed),
+    _spin_iterations(mmtk_stw_spin_iterations()),
+    _suspend_requested(0),
+    _companion_woken(0),
+    _suspend_reached(0),
+    _resume_requested(0),
+    _resume_reached(0) {
   set_name("MMTK VM Companion Thread");
   _lock = new Monitor(Mutex::nosafepoint,
                       "MMTkVMCompanionThread::_lock",
@@ -42,18 +50,45 @@ MMTkVMCompanionThread::~MMTkVMCompanionThread() {
   guarantee(false, "MMTkVMCompanionThread deletion must fix the race with VM termination");
 }
 
+// Change a state and wake up the threads blocked in wait_for_state.
+void MMTkVMCompanionThread::set_state(volatile stw_state* state, stw_state value) {
+  MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
+  Atomic::release_store(state, value);
+  _lock->notify_all();
+}
+
+// Wait until a state changes to the given value. Spin for up to _spin_iterations before blocking,
+// so that a short handoff costs neither a monitor wait nor a context switch.
+void MMTkVMCompanionThread::wait_for_state(volatile stw_state* state, stw_state value) {
+  for (size_t i = 0; i < _spin_iterations; i++) {
+    if (Atomic::load_acquire(state) == value) return;
+    SpinPause();
+  }
+  MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
+  while (Atomic::load_acquire(state) != value) {
+    _lock->wait_without_safepoint_check();
+  }
+}
+
+void MMTkVMCompanionThread::log_handoff(stw_state reached_state) {
+  if (reached_state == _threads_suspended) {
+    log_debug(gc, safepoint)("MMTk stop-the-world: companion wake-up %.3fms, safepoint %.3fms, GC thread wake-up %.3fms",
+                             (_companion_woken - _suspend_requested) / (double) NANOSECS_PER_MILLISEC,
+                             (_suspend_reached - _companion_woken) / (double) NANOSECS_PER_MILLISEC,
+                             (os::javaTimeNanos() - _suspend_reached) / (double) NANOSECS_PER_MILLISEC);
+  } else {
+    log_debug(gc, safepoint)("MMTk start-the-world: VM thread wake-up %.3fms, GC thread wake-up %.3fms",
+                             (_resume_reached - _resume_requested) / (double) NANOSECS_PER_MILLISEC,
+                             (os::javaTimeNanos() - _resume_reached) / (double) NANOSECS_PER_MILLISEC);
+  }
+}
+
 void MMTkVMCompanionThread::run() {
   for (;;) {
     // Wait for suspend request
     log_trace(gc)("MMTkVMCompanionThread: Waiting for suspend request...");
-    {
-      MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
-      assert(_reached_state == _threads_resumed, "Threads should be running at this moment.");
-      while (_desired_state != _threads_suspended) {
-        _lock->wait_without_safepoint_check();
-      }
-      assert(_reached_state == _threads_resumed, "Threads should still be running at this moment.");
-    }
+    wait_for_state(&_desired_state, _threads_suspended);
+    _companion_woken = os::javaTimeNanos();
 
     // Let the VM thread stop the world.
     log_trace(gc)("MMTkVMCompanionThread: Letting VMThread execute VM op...");
@@ -61,18 +96,11 @@ void MMTkVMCompanionThread::run() {
     // VMThread::execute() is blocking. The companion thread will be blocked
     // here waiting for the VM thread to execute op, and the VM thread will
     // be blocked in reach_suspended_and_wait_for_resume() until a GC thread
-    // calls request(_threads_resumed).
+    // calls request(_threads_resumed). The VM thread itself tells the GC thread
+    // that the world is resuming, so the next suspend request may already be
+    // pending when VMThread::execute() returns.
     VMThread::execute(&op);
 
-    // Tell the waiter thread that the world has resumed.
-    log_trace(gc)("MMTkVMCompanionThread: Notifying threads resumption...");
-    {
-      MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
-      assert(_desired_state == _threads_resumed, "start-the-world should be requested.");
-      assert(_reached_state == _threads_suspended, "Threads should still be suspended at this moment.");
-      _reached_state = _threads_resumed;
-      _lock->notify_all();
-    }
     {
       MutexLocker x(Heap_lock);
       if (Universe::has_reference_pending_list()) {
@@ -86,7 +114,8 @@ void MMTkVMCompanionThread::run() {
 // called by a GC thread.
 //
 // If wait_until_reached is true, the caller will block until all Java threads
-// have stopped, or until they have been waken up.
+// have stopped, or until the VM thread has left the safepoint operation and
+// is waking them up.
 //
 // If wait_until_reached is false, the caller will return immediately, while
 // the companion thread will ask the VM thread to perform the state transition
@@ -97,15 +126,16 @@ void MMTkVMCompanionThread::request(stw_state desired_state, bool wait_until_rea
   assert(Thread::current() != this, "Requests can only be made by GC threads. Found companion thread.");
   assert(!Thread::current()->is_Java_thread(), "Requests can only be made by GC threads. Found Java thread.");
 
-  MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
   assert(_desired_state != desired_state, "State %d already requested.", desired_state);
-  _desired_state = desired_state;
-  _lock->notify_all();
+  if (desired_state == _threads_suspended) {
+    _suspend_requested = os::javaTimeNanos();
+  } else {
+    _resume_requested = os::javaTimeNanos();
+  }
+  set_state(&_desired_state, desired_state);
 
   if (wait_until_reached) {
-    while (_reached_state != desired_state) {
-      _lock->wait_without_safepoint_check();
-    }
+    wait_for_reached(desired_state);
   }
 }
 
@@ -115,28 +145,27 @@ void MMTkVMCompanionThread::wait_for_reached(stw_state desired_state) {
   assert(!Thread::current()->is_VM_thread(), "Supposed to be called by GC threads. Found VM thread.");
   assert(Thread::current() != this, "Supposed to be called by GC threads. Found companion thread.");
   assert(!Thread::current()->is_Java_thread(), "Supposed to be called by GC threads. Found Java thread.");
-
-  MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
   assert(_desired_state == desired_state, "State %d not requested.", desired_state);
 
-  while (_reached_state != desired_state) {
-    _lock->wait_without_safepoint_check();
-  }
+  wait_for_state(&_reached_state, desired_state);
+  log_handoff(desired_state);
 }
 
 // Called by the VM thread to indicate that all Java threads have stopped.
 // This method will block until the GC requests start-the-world.
 void MMTkVMCompanionThread::reach_suspended_and_wait_for_resume() {
   assert(Thread::current()->is_VM_thread(), "reach_suspended_and_wait_for_resume can only be executed by the VM thread");
-
-  MutexLocker locker(_lock, Mutex::_no_safepoint_check_flag);
+  assert(_reached_state == _threads_resumed, "Threads should still be running at this moment.");
 
   // Tell the waiter thread that the world has stopped.
-  _reached_state = _threads_suspended;
-  _lock->notify_all();
+  _suspend_reached = os::javaTimeNanos();
+  set_state(&_reached_state, _threads_suspended);
 
   // Wait until resume-the-world is requested
-  while (_desired_state != _threads_resumed) {
-    _lock->wait_without_safepoint_check();
-  }
+  wait_for_state(&_desired_state, _threads_resumed);
+
+  // Tell the waiter thread directly that the world is resuming, instead of
+  // waking the companion thread to do it after the safepoint ends.
+  _resume_reached = os::javaTimeNanos();
+  set_state(&_reached_state, _threads_resumed);
 }
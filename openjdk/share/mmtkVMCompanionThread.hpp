@@ -48,8 +48,22 @@ public:
   };
 private:
   Monitor* _lock;
-  stw_state _desired_state;
-  stw_state _reached_state;
+  volatile stw_state _desired_state;
+  volatile stw_state _reached_state;
+  // How many times a thread waiting for a state change spins before it blocks on _lock
+  size_t _spin_iterations;
+
+  // Timestamps (os::javaTimeNanos) of each leg of the last stop-the-world and start-the-world,
+  // logged with -Xlog:gc+safepoint=debug
+  jlong _suspend_requested;
+  jlong _companion_woken;
+  jlong _suspend_reached;
+  jlong _resume_requested;
+  jlong _resume_reached;
+
+  void set_state(volatile stw_state* state, stw_state value);
+  void wait_for_state(volatile stw_state* state, stw_state value);
+  void log_handoff(stw_state reached_state);
 
 public:
   // Constructor